@@ -0,0 +1,561 @@
+/* Throughput benchmarks, written as JSON for tracking across releases.
+ *
+ * - Whether the core was built with C6502_LOGGING, the traces cost more than the rest.
+ * - bench/load_test.bin, made by scripts/make_load_test.py: a straight run of every load
+ *   mode, TXS and NOP through 64 KB, checked against the outcome stored in the image.
+ *   It's run again and again and is the headline number.
+ * - One micro benchmark per addressing mode, each a long run of the same load, and the
+ *   same runs with cycle exact and fast timing, the fastest of five runs each.
+ * - Long runs of LDA #/LDX # pairs and of LDA zp/STA zp pairs, each run plainly and as
+ *   superinstructions, the fastest of five runs each and how many times faster the
+ *   superinstructions are.
+ * - Linear and recursive disassembly of a 64 KB image of random bytes.
+ * - Reads and writes through Memory.
+ * - Reads and bank switches through a 1 MB UxROM BankedMemory.
+ * - A 100000 cycle run, executed and answered by a RunCache.
+ *
+ * Usage: c6502-bench [-o output.json]
+ */
+
+#include "c6502/c6502.h"
+#include "c6502/c6502Disassembler.h"
+#include "c6502/c6502Mapper.h"
+#include "c6502/c6502RunCache.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifndef C6502_LOAD_TEST_BIN
+#define C6502_LOAD_TEST_BIN "load_test.bin"
+#endif
+
+namespace c6502
+{
+namespace bench
+{
+using Clock = std::chrono::steady_clock;
+
+static constexpr u16 loadTestStart = 0x0400;
+static constexpr u16 loadTestResult = 0x0200;
+static constexpr u64 loadTestRuns = 2'000;
+
+struct Throughput
+{
+    u64 instructions = 0;
+    u64 cycles = 0;
+    double seconds = 0.0;
+
+    double emulatedMHz() const
+    {
+        return seconds > 0.0 ? cycles / seconds / 1e6 : 0.0;
+    }
+
+    double nsPerInstruction() const
+    {
+        return instructions > 0 ? seconds * 1e9 / instructions : 0.0;
+    }
+
+    double cyclesPerInstruction() const
+    {
+        return instructions > 0 ? double(cycles) / instructions : 0.0;
+    }
+};
+
+double secondsSince(const Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void writeThroughput(std::FILE* out, const Throughput& throughput)
+{
+    std::fprintf(out,
+                 "\"instructions\": %llu, \"cycles\": %llu, \"seconds\": %.6f, "
+                 "\"emulated_mhz\": %.3f, \"ns_per_instruction\": %.3f, "
+                 "\"cycles_per_instruction\": %.3f",
+                 static_cast<unsigned long long>(throughput.instructions),
+                 static_cast<unsigned long long>(throughput.cycles),
+                 throughput.seconds,
+                 throughput.emulatedMHz(),
+                 throughput.nsPerInstruction(),
+                 throughput.cyclesPerInstruction());
+}
+
+/// Reads an image of at most 64 KB, empty when there's none
+std::vector<char> readImage(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::vector<char> image{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    if (image.size() > Memory::MEM_MAX)
+    {
+        image.clear();
+    }
+    return image;
+}
+
+void runLoadTest(std::FILE* out, const std::string& path)
+{
+    const std::vector<char> image = readImage(path);
+
+    std::fprintf(out, "  \"load_test\": {");
+    if (image.size() != Memory::MEM_MAX)
+    {
+        std::fprintf(out, "\"status\": \"missing\", \"path\": \"%s\"},\n", path.c_str());
+        return;
+    }
+
+    auto memory = std::make_unique<Memory>();
+    std::copy(image.begin(), image.end(), memory->data.begin());
+    const Memory& result = *memory;
+    const u16 expectedPC = result[loadTestResult + 5] | (result[loadTestResult + 6] << 8);
+    u64 expectedCycles = 0;
+    u64 expectedInstructions = 0;
+    for (int i = 3; i >= 0; --i)
+    {
+        expectedCycles = (expectedCycles << 8) | result[loadTestResult + 7 + i];
+        expectedInstructions = (expectedInstructions << 8) | result[loadTestResult + 11 + i];
+    }
+
+    Cpu cpu;
+    bool passed = true;
+    Throughput throughput;
+    const auto start = Clock::now();
+    for (u64 i = 0; i < loadTestRuns; ++i)
+    {
+        cpu.resetRegisters(loadTestStart);
+        const StopStatus status = cpu.runUntil(cpu.cycles() + 2 * expectedCycles, *memory);
+        throughput.cycles += status.cycles;
+        throughput.instructions += status.instructions;
+
+        passed = passed && status.reason == StopReason::InvalidOpCode &&
+                 status.PC == expectedPC && status.cycles == expectedCycles &&
+                 status.instructions == expectedInstructions &&
+                 cpu.A == result[loadTestResult] && cpu.X == result[loadTestResult + 1] &&
+                 cpu.Y == result[loadTestResult + 2] && cpu.SP == result[loadTestResult + 3] &&
+                 cpu.SR == result[loadTestResult + 4];
+    }
+    throughput.seconds = secondsSince(start);
+
+    std::fprintf(out, "\"status\": \"%s\", \"runs\": %llu, ",
+                 passed ? "passed" : "failed",
+                 static_cast<unsigned long long>(loadTestRuns));
+    writeThroughput(out, throughput);
+    std::fprintf(out, "},\n");
+}
+
+struct AddressingMode
+{
+    const char* name;
+    Cpu::OP opCode;
+    u8 operandLow;
+    u8 operandHigh;
+    u8 X;
+    u8 Y;
+};
+
+/* Operands are picked so that the _page_cross variants add one to $12FF, the indirect
+ * modes use the pointer to $12FF stored at $0040. */
+static constexpr AddressingMode addressingModes[] = {
+    {"implied", Cpu::OP::NOP, 0, 0, 0, 0},
+    {"immediate", Cpu::OP::LDA_IM, 0x42, 0, 0, 0},
+    {"zero_page", Cpu::OP::LDA_ZP, 0x42, 0, 0, 0},
+    {"zero_page_x", Cpu::OP::LDA_ZPX, 0x42, 0, 1, 0},
+    {"absolute", Cpu::OP::LDA_ABS, 0x34, 0x12, 0, 0},
+    {"absolute_x", Cpu::OP::LDA_ABSX, 0x34, 0x12, 1, 0},
+    {"absolute_x_page_cross", Cpu::OP::LDA_ABSX, 0xFF, 0x12, 1, 0},
+    {"indexed_indirect", Cpu::OP::LDA_IND_ZPX, 0x3F, 0, 1, 0},
+    {"indirect_indexed", Cpu::OP::LDA_IND_ZPY, 0x40, 0, 0, 0},
+    {"indirect_indexed_page_cross", Cpu::OP::LDA_IND_ZPY, 0x40, 0, 0, 1},
+};
+
+/// Fills memory from $0200 with the same instruction and runs through it repeatedly
+template <typename TestCpu = Cpu>
+Throughput runAddressingMode(const AddressingMode& mode, const u64 totalCycles)
+{
+    static constexpr u16 programStart = 0x0200;
+    static constexpr u16 programEnd = 0xE000;
+
+    TestCpu cpu;
+    auto memory = std::make_unique<Memory>();
+    memory->initialize();
+    (*memory)[0x0040] = 0xFF;
+    (*memory)[0x0041] = 0x12;
+
+    const u8 length = (mode.opCode == Cpu::OP::NOP) ? 1 : (mode.operandHigh != 0 ? 3 : 2);
+    const u16 count = (programEnd - programStart) / length;
+    for (u16 i = 0; i < count; ++i)
+    {
+        const u16 address = programStart + i * length;
+        (*memory)[address] = mode.opCode;
+        (*memory)[address + 1] = mode.operandLow;
+        (*memory)[address + 2] = mode.operandHigh;
+    }
+    const u16 lastAddress = programStart + (count - 1) * length;
+
+    cpu.resetRegisters(programStart);
+    cpu.X = mode.X;
+    cpu.Y = mode.Y;
+
+    Throughput throughput;
+    const auto start = Clock::now();
+    while (throughput.cycles < totalCycles)
+    {
+        // Stop short of the end of the program, then start over
+        const u16 remaining = (lastAddress - cpu.PC) / length;
+        if (remaining == 0)
+        {
+            cpu.PC = programStart;
+            continue;
+        }
+
+        const s32 cycles = remaining * 2;
+        const u16 PC = cpu.PC;
+        throughput.cycles += cpu.execute(cycles, *memory);
+        throughput.instructions += (cpu.PC - PC) / length;
+    }
+    throughput.seconds = secondsSince(start);
+
+    return throughput;
+}
+
+void runAddressingModes(std::FILE* out)
+{
+    std::fprintf(out, "  \"addressing_modes\": [\n");
+    for (const AddressingMode& mode : addressingModes)
+    {
+        const std::string_view opCode = Cpu::OpCodeToString(mode.opCode);
+        std::fprintf(out,
+                     "    {\"name\": \"%s\", \"opcode\": \"%.*s\", ",
+                     mode.name,
+                     static_cast<int>(opCode.size()),
+                     opCode.data());
+        writeThroughput(out, runAddressingMode(mode, 10'000'000));
+        std::fprintf(out, "}%s\n", &mode == std::end(addressingModes) - 1 ? "" : ",");
+    }
+    std::fprintf(out, "  ],\n");
+}
+
+/// The fastest of a few runs, a single one is too noisy to compare timings of a few percent
+template <typename Run>
+Throughput fastestOf(const int runs, const Run& run)
+{
+    Throughput fastest = run();
+    for (int i = 1; i < runs; ++i)
+    {
+        const Throughput throughput = run();
+        if (throughput.nsPerInstruction() < fastest.nsPerInstruction())
+        {
+            fastest = throughput;
+        }
+    }
+    return fastest;
+}
+
+void runTiming(std::FILE* out)
+{
+    std::fprintf(out, "  \"timing\": [\n");
+    for (const AddressingMode& mode : addressingModes)
+    {
+        std::fprintf(out, "    {\"name\": \"%s\", \"cycle_exact\": {", mode.name);
+        writeThroughput(out, fastestOf(5, [&]() {
+            return runAddressingMode<Cpu>(mode, 10'000'000);
+        }));
+        std::fprintf(out, "}, \"fast\": {");
+        writeThroughput(out, fastestOf(5, [&]() {
+            return runAddressingMode<FastCpu>(mode, 10'000'000);
+        }));
+        std::fprintf(out, "}}%s\n", &mode == std::end(addressingModes) - 1 ? "" : ",");
+    }
+    std::fprintf(out, "  ],\n");
+}
+
+using RunFunction = StopStatus (Cpu::*)(s32, Memory&) noexcept;
+
+/// Fills memory from $0200 with one pair of instructions after another and runs through it
+/// repeatedly. The run function is called through a pointer so that neither loop is inlined
+/// into the benchmark.
+Throughput runPairs(const RunFunction run, const std::array<u8, 4>& pair, const u64 totalCycles)
+{
+    static constexpr u16 programStart = 0x0200;
+    static constexpr u16 programEnd = 0xE000;
+    static constexpr u16 pairLength = 4;
+
+    Cpu cpu;
+    auto memory = std::make_unique<Memory>();
+    memory->initialize();
+    for (u16 address = programStart; address < programEnd; address += pairLength)
+    {
+        std::copy(pair.begin(), pair.end(), &(*memory)[address]);
+    }
+
+    cpu.resetRegisters(programStart);
+    Throughput throughput;
+    const auto start = Clock::now();
+    while (throughput.cycles < totalCycles)
+    {
+        // Stop short of the end of the program, then start over
+        const s32 cycles = (programEnd - cpu.PC) - pairLength;
+        if (cycles <= 0)
+        {
+            cpu.PC = programStart;
+            continue;
+        }
+
+        const StopStatus status = (cpu.*run)(cycles, *memory);
+        throughput.cycles += status.cycles;
+        throughput.instructions += status.instructions;
+    }
+    throughput.seconds = secondsSince(start);
+
+    return throughput;
+}
+
+/// Runs a stream of pairs plainly and as superinstructions, the fastest of five runs each
+void runPairs(std::FILE* out, const char* name, const std::array<u8, 4>& pair, const bool last)
+{
+    const Throughput plain = fastestOf(5, [&]() {
+        return runPairs(&Cpu::run, pair, 10'000'000);
+    });
+    const Throughput fused = fastestOf(5, [&]() {
+        return runPairs(&Cpu::runFused, pair, 10'000'000);
+    });
+
+    std::fprintf(out, "    \"%s\": {\"plain\": {", name);
+    writeThroughput(out, plain);
+    std::fprintf(out, "}, \"fused\": {");
+    writeThroughput(out, fused);
+    std::fprintf(out,
+                 "}, \"speedup\": %.3f}%s\n",
+                 fused.nsPerInstruction() > 0.0
+                     ? plain.nsPerInstruction() / fused.nsPerInstruction()
+                     : 0.0,
+                 last ? "" : ",");
+}
+
+void runSuperinstructions(std::FILE* out)
+{
+    std::fprintf(out, "  \"superinstructions\": {\n");
+    runPairs(out, "load_pairs", {Cpu::OP::LDA_IM, 0x34, Cpu::OP::LDX_IM, 0x12}, false);
+    runPairs(out, "load_store_pairs", {Cpu::OP::LDA_ZP, 0x10, Cpu::OP::STA_ZP, 0x20}, true);
+    std::fprintf(out, "  },\n");
+}
+
+void runDisassembly(std::FILE* out)
+{
+    auto memory = std::make_unique<Memory>();
+    u32 seed = 1;
+    for (u8& byte : memory->data)
+    {
+        seed = seed * 1'103'515'245 + 12'345;
+        byte = static_cast<u8>(seed >> 16);
+    }
+
+    // Every instruction of a sweep through the whole image, formatted as text
+    const auto sweepStart = Clock::now();
+    Decoder<Nmos6502> decoder(*memory, 0x0000);
+    u64 instructions = 0;
+    u64 textLength = 0;
+    char text[c_formatBufferSize];
+    u16 previous = 0;
+    do
+    {
+        previous = decoder.address();
+        textLength += format(decoder.next(), text, sizeof(text));
+        instructions++;
+    } while (decoder.address() > previous);
+    const double sweepSeconds = secondsSince(sweepStart);
+
+    // Random bytes rarely run far, so every page start is an entry point as well
+    const auto traceStart = Clock::now();
+    auto map = std::make_unique<CodeMap<Nmos6502>>();
+    map->addVectors(*memory);
+    for (u32 address = 0; address < Memory::MEM_MAX; address += 0x100)
+    {
+        map->addEntry(static_cast<u16>(address));
+    }
+    map->trace(*memory);
+    const double traceSeconds = secondsSince(traceStart);
+
+    std::fprintf(out,
+                 "  \"disassembly\": {\"sweep_instructions\": %llu, \"sweep_ms\": %.3f, "
+                 "\"text_bytes\": %llu, \"traced_instructions\": %llu, \"trace_ms\": %.3f},\n",
+                 static_cast<unsigned long long>(instructions),
+                 sweepSeconds * 1e3,
+                 static_cast<unsigned long long>(textLength),
+                 static_cast<unsigned long long>(map->instructionCount()),
+                 traceSeconds * 1e3);
+}
+
+void runMemory(std::FILE* out)
+{
+    static constexpr u64 accesses = 100'000'000;
+
+    auto memory = std::make_unique<Memory>();
+    memory->initialize();
+
+    // The stride visits every address in a cache unfriendly order
+    const auto writeStart = Clock::now();
+    u16 address = 0;
+    for (u64 i = 0; i < accesses; ++i)
+    {
+        (*memory)[address] = static_cast<u8>(i);
+        address += 0x1235;
+    }
+    const double writeSeconds = secondsSince(writeStart);
+
+    const Memory& constMemory = *memory;
+    const auto readStart = Clock::now();
+    u64 sum = 0;
+    for (u64 i = 0; i < accesses; ++i)
+    {
+        sum += constMemory[address];
+        address += 0x1235;
+    }
+    const double readSeconds = secondsSince(readStart);
+
+    std::fprintf(out,
+                 "  \"memory\": {\"accesses\": %llu, \"read_ns\": %.3f, \"write_ns\": %.3f, "
+                 "\"checksum\": %llu},\n",
+                 static_cast<unsigned long long>(accesses),
+                 readSeconds * 1e9 / accesses,
+                 writeSeconds * 1e9 / accesses,
+                 static_cast<unsigned long long>(sum));
+}
+
+void runBankedMemory(std::FILE* out)
+{
+    static constexpr u64 accesses = 100'000'000;
+    static constexpr u64 switches = 10'000'000;
+
+    BankedMemory memory(1024 * 1024, 2 * 1024, std::make_unique<UxromMapper>());
+    for (std::size_t i = 0; i < memory.romSize(); ++i)
+    {
+        memory.rom()[i] = static_cast<u8>(i >> 14);
+    }
+
+    const auto readStart = Clock::now();
+    u16 address = 0;
+    u64 sum = 0;
+    for (u64 i = 0; i < accesses; ++i)
+    {
+        sum += memory[address];
+        address += 0x1235;
+    }
+    const double readSeconds = secondsSince(readStart);
+
+    // Every switch is followed by a read from the new bank
+    const auto switchStart = Clock::now();
+    for (u64 i = 0; i < switches; ++i)
+    {
+        memory.write(0x8000, static_cast<u8>(i));
+        sum += memory[0x8000];
+    }
+    const double switchSeconds = secondsSince(switchStart);
+
+    std::fprintf(out,
+                 "  \"banked_memory\": {\"read_ns\": %.3f, \"switch_ns\": %.3f, "
+                 "\"checksum\": %llu},\n",
+                 readSeconds * 1e9 / accesses,
+                 switchSeconds * 1e9 / switches,
+                 static_cast<unsigned long long>(sum));
+}
+
+void runRunCache(std::FILE* out)
+{
+    static constexpr s32 budget = 100'000;
+    static constexpr u64 repeats = 1'000;
+
+    auto memory = std::make_unique<Memory>();
+    std::fill(std::begin(memory->data), std::end(memory->data), static_cast<u8>(Cpu::OP::NOP));
+    Cpu cpu;
+
+    const auto runStart = Clock::now();
+    for (u64 i = 0; i < repeats; ++i)
+    {
+        cpu.resetRegisters(0x0000);
+        cpu.run(budget, *memory);
+    }
+    const double runSeconds = secondsSince(runStart);
+
+    // Every run but the first is a hit, with the memory hashed each time or kept up to date
+    RunCache cache(1024 * 1024);
+    const auto hashedStart = Clock::now();
+    for (u64 i = 0; i < repeats; ++i)
+    {
+        cpu.resetRegisters(0x0000);
+        cache.run(cpu, budget, *memory);
+    }
+    const double hashedSeconds = secondsSince(hashedStart);
+
+    MemoryHash hash(*memory);
+    const auto keptStart = Clock::now();
+    for (u64 i = 0; i < repeats; ++i)
+    {
+        cpu.resetRegisters(0x0000);
+        cache.run(cpu, budget, *memory, hash);
+    }
+    const double keptSeconds = secondsSince(keptStart);
+
+    std::fprintf(out,
+                 "  \"run_cache\": {\"cycles\": %d, \"run_us\": %.3f, \"hit_us\": %.3f, "
+                 "\"hit_kept_hash_us\": %.3f, \"hits\": %llu}\n",
+                 budget,
+                 runSeconds * 1e6 / repeats,
+                 hashedSeconds * 1e6 / repeats,
+                 keptSeconds * 1e6 / repeats,
+                 static_cast<unsigned long long>(cache.stats().hits));
+}
+
+} // namespace bench
+} // namespace c6502
+
+int main(int argc, char* argv[])
+{
+    using namespace c6502::bench;
+
+    const std::string loadTest = C6502_LOAD_TEST_BIN;
+    std::FILE* out = stdout;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const std::string option = argv[i];
+        if (option == "-o")
+        {
+            out = std::fopen(argv[i + 1], "w");
+            if (out == nullptr)
+            {
+                std::perror(argv[i + 1]);
+                return 1;
+            }
+        }
+        else
+        {
+            std::fprintf(stderr, "Usage: %s [-o output.json]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::fprintf(out, "{\n");
+    std::fprintf(out, "  \"logging\": %s,\n", c6502::c_logging ? "true" : "false");
+    runLoadTest(out, loadTest);
+    runAddressingModes(out);
+    runTiming(out);
+    runSuperinstructions(out);
+    runDisassembly(out);
+    runMemory(out);
+    runBankedMemory(out);
+    runRunCache(out);
+    std::fprintf(out, "}\n");
+
+    if (out != stdout)
+    {
+        std::fclose(out);
+    }
+    return 0;
+}
@@ -0,0 +1,674 @@
+/* Differential fuzzer between a reference interpreter and the execution engines.
+ *
+ * Every case is a random instruction stream placed on top of random memory with random
+ * registers, built from the opcodes of a variant the core executes. The memory is built
+ * once per case and copied for every run. The reference is a switch interpreter of its own
+ * that only shares the opcode metadata with the core, so a bug in an instruction handler
+ * shows up as a divergence like a bug in an engine does. Every engine runs the same case
+ * and the final registers, memory, executed cycles and stop reason must match the
+ * reference. All cases run for every variant, spread over all cores. The divergence with
+ * the lowest seed is minimized by dropping instructions and printed as a reproducer.
+ *
+ * Usage: c6502-difffuzz [-n cases] [-s first seed] [-j threads]
+ */
+
+#include "c6502/c6502.h"
+#include "c6502/c6502Coverage.h"
+#include "c6502/c6502Disassembler.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace c6502
+{
+namespace fuzz
+{
+
+/// Opcodes the instruction streams are built from, every one of the variant the core executes
+template <typename Variant>
+const std::vector<u8>& opCodePool()
+{
+    static const std::vector<u8> pool = []() {
+        std::vector<u8> opCodes;
+        for (unsigned opCode = 0; opCode <= 0xFF; ++opCode)
+        {
+            if (BasicCpu<Variant>::isValidOpCode(static_cast<u8>(opCode)))
+            {
+                opCodes.push_back(static_cast<u8>(opCode));
+            }
+        }
+        return opCodes;
+    }();
+    return pool;
+}
+
+template <typename Variant>
+struct Case
+{
+    u64 seed;
+    BasicCpu<Variant> cpu;
+    s32 cycles;
+    std::vector<std::vector<u8>> instructions;
+};
+
+struct Outcome
+{
+    CpuState cpu;
+    std::unique_ptr<Memory> memory;
+    u64 cycles;
+    bool invalidOpCode;
+};
+
+template <typename Variant>
+Case<Variant> generateCase(const u64 seed)
+{
+    std::mt19937_64 rng(seed);
+    auto byte = [&rng]() { return static_cast<u8>(rng()); };
+
+    Case<Variant> c;
+    c.seed = seed;
+    c.cpu.PC = static_cast<u16>(rng());
+    c.cpu.SP = byte();
+    c.cpu.A = byte();
+    c.cpu.X = byte();
+    c.cpu.Y = byte();
+    c.cpu.SR = byte();
+    c.cycles = static_cast<s32>(rng() % 200);
+
+    const std::size_t count = 1 + rng() % 32;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const std::vector<u8>& pool = opCodePool<Variant>();
+        const u8 opCode = pool[rng() % pool.size()];
+        std::vector<u8> instruction{opCode};
+        for (u8 operand = 1; operand < c_opCodeInfo<Variant>[opCode].length; ++operand)
+        {
+            instruction.push_back(byte());
+        }
+        c.instructions.push_back(std::move(instruction));
+    }
+
+    return c;
+}
+
+/// Random background derived from the seed with the instruction stream on top of it
+template <typename Variant>
+std::unique_ptr<Memory> buildMemory(const Case<Variant>& c)
+{
+    auto memory = std::make_unique<Memory>();
+
+    std::mt19937_64 rng(~c.seed);
+    for (std::size_t i = 0; i < Memory::MEM_MAX; i += sizeof(u64))
+    {
+        const u64 value = rng();
+        std::memcpy(&memory->data[i], &value, sizeof(value));
+    }
+
+    u16 address = c.cpu.PC;
+    for (const auto& instruction : c.instructions)
+    {
+        for (const u8 byte : instruction)
+        {
+            (*memory)[address++] = byte;
+        }
+    }
+
+    return memory;
+}
+
+/// What the reference does for an opcode
+enum class Operation : u8
+{
+    Invalid,
+    LoadA,
+    LoadX,
+    LoadY,
+    LoadAX,
+    StoreA,
+    StoreX,
+    StoreY,
+    TransferXToStackPointer,
+    NoOperation
+};
+
+/// The operations of a variant's opcodes, by mnemonic, Invalid for every one the reference
+/// doesn't know even when the core executes it
+template <typename Variant>
+const std::array<Operation, 256>& operations()
+{
+    static const std::array<Operation, 256> table = []() {
+        static constexpr std::pair<std::string_view, Operation> mnemonics[] = {
+            {"LDA", Operation::LoadA},
+            {"LDX", Operation::LoadX},
+            {"LDY", Operation::LoadY},
+            {"LAX", Operation::LoadAX},
+            {"STA", Operation::StoreA},
+            {"STX", Operation::StoreX},
+            {"STY", Operation::StoreY},
+            {"TXS", Operation::TransferXToStackPointer},
+            {"NOP", Operation::NoOperation},
+        };
+        std::array<Operation, 256> operations{};
+        for (unsigned opCode = 0; opCode <= 0xFF; ++opCode)
+        {
+            for (const auto& [mnemonic, operation] : mnemonics)
+            {
+                if (c_opCodeInfo<Variant>[opCode].mnemonic == mnemonic)
+                {
+                    operations[opCode] = operation;
+                }
+            }
+        }
+        return operations;
+    }();
+    return table;
+}
+
+/// Runs the case on the reference interpreter, from the cycle counts of the data sheets
+template <typename Variant>
+Outcome runReference(const Case<Variant>& c, const Memory& initial)
+{
+    Outcome outcome{c.cpu, std::make_unique<Memory>(initial), 0, false};
+    CpuState& cpu = outcome.cpu;
+    Memory& memory = *outcome.memory;
+
+    const auto fetch = [&cpu, &memory]() { return memory[cpu.PC++]; };
+    const auto zeroPageWord = [&memory](const u8 address) {
+        return static_cast<u16>(memory[address] | memory[static_cast<u8>(address + 1)] << 8);
+    };
+
+    const u64 budget = c.cycles > 0 ? static_cast<u64>(c.cycles) : 0;
+    while (outcome.cycles < budget)
+    {
+        const u8 opCode = fetch();
+        const Operation operation = operations<Variant>()[opCode];
+        if (operation == Operation::Invalid)
+        {
+            // Only the opcode fetch
+            outcome.cycles += 1;
+            outcome.invalidOpCode = true;
+            break;
+        }
+
+        // Reads take a cycle more when indexing crosses a page, stores always take it
+        const bool store = operation == Operation::StoreA || operation == Operation::StoreX ||
+                           operation == Operation::StoreY;
+        u16 address = 0;
+        u64 cycles = 2;
+        switch (c_opCodeInfo<Variant>[opCode].mode)
+        {
+            case AddrMode::Immediate:
+            {
+                address = cpu.PC++;
+                break;
+            }
+            case AddrMode::ZeroPage:
+            {
+                address = fetch();
+                cycles = 3;
+                break;
+            }
+            case AddrMode::ZeroPageX:
+            case AddrMode::ZeroPageY:
+            {
+                const u8 index = c_opCodeInfo<Variant>[opCode].mode == AddrMode::ZeroPageX
+                                     ? cpu.X
+                                     : cpu.Y;
+                address = static_cast<u8>(fetch() + index);
+                cycles = 4;
+                break;
+            }
+            case AddrMode::Absolute:
+            {
+                address = fetch();
+                address |= fetch() << 8;
+                cycles = 4;
+                break;
+            }
+            case AddrMode::AbsoluteX:
+            case AddrMode::AbsoluteY:
+            {
+                const u8 index = c_opCodeInfo<Variant>[opCode].mode == AddrMode::AbsoluteX
+                                     ? cpu.X
+                                     : cpu.Y;
+                u16 base = fetch();
+                base |= fetch() << 8;
+                address = static_cast<u16>(base + index);
+                cycles = 4 + ((store || (base ^ address) > 0xFF) ? 1 : 0);
+                break;
+            }
+            case AddrMode::ZeroPageIndirect:
+            {
+                address = zeroPageWord(fetch());
+                cycles = 5;
+                break;
+            }
+            case AddrMode::ZeroPageIndirectX:
+            {
+                address = zeroPageWord(static_cast<u8>(fetch() + cpu.X));
+                cycles = 6;
+                break;
+            }
+            case AddrMode::ZeroPageIndirectY:
+            {
+                const u16 pointer = zeroPageWord(fetch());
+                address = static_cast<u16>(pointer + cpu.Y);
+                cycles = 5 + ((store || (pointer ^ address) > 0xFF) ? 1 : 0);
+                break;
+            }
+            default:
+            {
+                break;
+            }
+        }
+
+        const auto setFlags = [&cpu](const u8 value) {
+            cpu.SR &= ~(CpuState::c_zeroFlag | CpuState::c_negativeFlag);
+            cpu.SR |= (value == 0 ? CpuState::c_zeroFlag : 0) | (value & CpuState::c_negativeFlag);
+        };
+        switch (operation)
+        {
+            case Operation::LoadA:
+            {
+                cpu.A = memory[address];
+                setFlags(cpu.A);
+                break;
+            }
+            case Operation::LoadX:
+            {
+                cpu.X = memory[address];
+                setFlags(cpu.X);
+                break;
+            }
+            case Operation::LoadY:
+            {
+                cpu.Y = memory[address];
+                setFlags(cpu.Y);
+                break;
+            }
+            case Operation::LoadAX:
+            {
+                cpu.A = cpu.X = memory[address];
+                setFlags(cpu.A);
+                break;
+            }
+            case Operation::StoreA:
+            {
+                memory[address] = cpu.A;
+                break;
+            }
+            case Operation::StoreX:
+            {
+                memory[address] = cpu.X;
+                break;
+            }
+            case Operation::StoreY:
+            {
+                memory[address] = cpu.Y;
+                break;
+            }
+            case Operation::TransferXToStackPointer:
+            {
+                cpu.SP = cpu.X;
+                break;
+            }
+            default:
+            {
+                break;
+            }
+        }
+        outcome.cycles += cycles;
+    }
+
+    return outcome;
+}
+
+/// Runs the case through an engine that reports how it stopped
+template <typename Variant, typename Run>
+Outcome runEngine(const Case<Variant>& c, const Memory& initial, Run run)
+{
+    BasicCpu<Variant> cpu = c.cpu;
+    auto memory = std::make_unique<Memory>(initial);
+
+    const StopStatus status = run(cpu, c.cycles, *memory);
+    return {cpu, std::move(memory), status.cycles, status.reason == StopReason::InvalidOpCode};
+}
+
+/// Runs the case through execute(), which throws on an invalid opcode. The cycles run up to
+/// it are taken from the CPU's clock then.
+template <typename Variant, typename Execute>
+Outcome runExecuteEngine(const Case<Variant>& c, const Memory& initial, Execute execute)
+{
+    return runEngine(c, initial, [&execute](BasicCpu<Variant>& cpu, s32 cycles, Memory& memory) {
+        const u64 start = cpu.cycles();
+        StopStatus status{StopReason::CyclesExhausted, 0, cpu.PC, 0, 0};
+        try
+        {
+            status.cycles = static_cast<u64>(execute(cpu, cycles, memory));
+        }
+        catch (const InvalidOpCode& error)
+        {
+            status = {StopReason::InvalidOpCode, error.opCode(), cpu.PC, cpu.cycles() - start, 0};
+        }
+        return status;
+    });
+}
+
+template <typename Variant>
+Outcome runExecute(const Case<Variant>& c, const Memory& initial)
+{
+    return runExecuteEngine(c, initial, [](BasicCpu<Variant>& cpu, s32 cycles, Memory& memory) {
+        return cpu.execute(cycles, memory);
+    });
+}
+
+template <typename Variant>
+Outcome runExecuteWithCoverage(const Case<Variant>& c, const Memory& initial)
+{
+    return runExecuteEngine(c, initial, [](BasicCpu<Variant>& cpu, s32 cycles, Memory& memory) {
+        static thread_local std::vector<u8> map(EdgeCoverage::MAP_SIZE);
+        EdgeCoverage coverage(map.data());
+        return cpu.execute(cycles, memory, coverage);
+    });
+}
+
+/// Hooks that do some work, to make sure hooking doesn't change what the CPU does
+struct CountingHooks : public NoHooks
+{
+    void preInstruction(const CpuState& /*cpu*/, const u16 /*address*/, const u8 /*opCode*/)
+    {
+        instructions++;
+    }
+
+    void onRead(const u16 /*address*/, const u8 /*value*/)
+    {
+        reads++;
+    }
+
+    u64 instructions = 0;
+    u64 reads = 0;
+};
+
+template <typename Variant>
+Outcome runExecuteWithHooks(const Case<Variant>& c, const Memory& initial)
+{
+    return runEngine(c, initial, [](BasicCpu<Variant>& cpu, s32 cycles, Memory& memory) {
+        BasicCpu<Variant, CountingHooks> hookedCpu;
+        static_cast<CpuState&>(hookedCpu) = cpu;
+        const StopStatus status = hookedCpu.run(cycles, memory);
+        static_cast<CpuState&>(cpu) = hookedCpu;
+        return status;
+    });
+}
+
+template <typename Variant>
+Outcome runFused(const Case<Variant>& c, const Memory& initial)
+{
+    return runEngine(c, initial, [](BasicCpu<Variant>& cpu, s32 cycles, Memory& memory) {
+        return cpu.runFused(cycles, memory);
+    });
+}
+
+template <typename Variant>
+Outcome runFast(const Case<Variant>& c, const Memory& initial)
+{
+    return runEngine(c, initial, [](BasicCpu<Variant>& cpu, s32 cycles, Memory& memory) {
+        BasicCpu<Variant, NoHooks, Fast> fastCpu;
+        static_cast<CpuState&>(fastCpu) = cpu;
+        const StopStatus status = fastCpu.run(cycles, memory);
+        static_cast<CpuState&>(cpu) = fastCpu;
+        return status;
+    });
+}
+
+template <typename Variant>
+struct Engine
+{
+    const char* name;
+    Outcome (*run)(const Case<Variant>&, const Memory&);
+};
+
+/// Every engine is checked against runReference
+template <typename Variant>
+static constexpr Engine<Variant> engines[] = {
+    {"execute", runExecute<Variant>},
+    {"execute+coverage", runExecuteWithCoverage<Variant>},
+    {"execute+hooks", runExecuteWithHooks<Variant>},
+    {"run+fused", runFused<Variant>},
+    {"run+fast", runFast<Variant>},
+};
+
+/// Describes how two outcomes differ, empty if they match
+std::string compare(const Outcome& expected, const Outcome& actual)
+{
+    std::string differences;
+    if (expected.invalidOpCode != actual.invalidOpCode)
+    {
+        differences += "  stop reason differs\n";
+        return differences;
+    }
+
+    if (expected.cpu != actual.cpu)
+    {
+        differences += "  expected " + expected.cpu.toString() + "\n";
+        differences += "  actual   " + actual.cpu.toString() + "\n";
+    }
+    if (expected.cycles != actual.cycles)
+    {
+        differences += "  cycles " + std::to_string(expected.cycles) + " vs " +
+                       std::to_string(actual.cycles) + "\n";
+    }
+    if (*expected.memory != *actual.memory)
+    {
+        for (std::size_t i = 0; i < Memory::MEM_MAX; ++i)
+        {
+            if ((*expected.memory)[i] != (*actual.memory)[i])
+            {
+                differences += "  memory differs first at " + std::to_string(i) + "\n";
+                break;
+            }
+        }
+    }
+
+    return differences;
+}
+
+/// Returns the first engine that diverges from the reference, or nullptr
+template <typename Variant>
+const Engine<Variant>* findDivergence(const Case<Variant>& c)
+{
+    const std::unique_ptr<Memory> initial = buildMemory(c);
+    const Outcome expected = runReference(c, *initial);
+    for (const Engine<Variant>& engine : engines<Variant>)
+    {
+        if (!compare(expected, engine.run(c, *initial)).empty())
+        {
+            return &engine;
+        }
+    }
+    return nullptr;
+}
+
+/// Drops instructions and cycles for as long as the engine still diverges
+template <typename Variant>
+Case<Variant> minimize(Case<Variant> c, const Engine<Variant>& engine)
+{
+    auto diverges = [&engine](const Case<Variant>& candidate) {
+        const std::unique_ptr<Memory> initial = buildMemory(candidate);
+        return !compare(runReference(candidate, *initial), engine.run(candidate, *initial)).empty();
+    };
+
+    bool shrunk = true;
+    while (shrunk)
+    {
+        shrunk = false;
+
+        for (std::size_t i = c.instructions.size(); i-- > 0;)
+        {
+            Case<Variant> candidate = c;
+            candidate.instructions.erase(candidate.instructions.begin() + i);
+            if (diverges(candidate))
+            {
+                c = std::move(candidate);
+                shrunk = true;
+            }
+        }
+
+        while (c.cycles > 0)
+        {
+            Case<Variant> candidate = c;
+            candidate.cycles--;
+            if (!diverges(candidate))
+            {
+                break;
+            }
+            c = std::move(candidate);
+            shrunk = true;
+        }
+    }
+
+    return c;
+}
+
+template <typename Variant>
+void printReproducer(const char* variant, const Case<Variant>& c, const Engine<Variant>& engine)
+{
+    std::printf("Divergence in engine '%s' of %s for seed %llu\n",
+                engine.name,
+                variant,
+                static_cast<unsigned long long>(c.seed));
+    std::printf("Initial state: %s\n", c.cpu.toString().c_str());
+    std::printf("Cycle budget: %d\n", c.cycles);
+    std::printf("Program:\n");
+
+    const std::unique_ptr<Memory> memory = buildMemory(c);
+    u16 address = c.cpu.PC;
+    for (const auto& instruction : c.instructions)
+    {
+        std::printf("  %04x:", address);
+        for (const u8 byte : instruction)
+        {
+            std::printf(" %02x", byte);
+        }
+        char text[c_formatBufferSize];
+        format(decode<Variant>(*memory, address), text, sizeof(text));
+        std::printf("  %s\n", text);
+        address += static_cast<u16>(instruction.size());
+    }
+
+    const Outcome expected = runReference(c, *memory);
+    std::printf("Differences:\n%s", compare(expected, engine.run(c, *memory)).c_str());
+}
+
+/// Runs every case for a variant, prints the first divergence and returns false if any
+template <typename Variant>
+bool fuzzVariant(const char* variant,
+                 const u64 caseCount,
+                 const u64 firstSeed,
+                 const unsigned threadCount)
+{
+    // Workers skip every seed past the lowest diverging one found so far
+    std::atomic<u64> firstDivergence{std::numeric_limits<u64>::max()};
+
+    std::vector<std::thread> workers;
+    for (unsigned worker = 0; worker < threadCount; ++worker)
+    {
+        workers.emplace_back([&, worker]() {
+            for (u64 seed = firstSeed + worker; seed < firstSeed + caseCount;
+                 seed += threadCount)
+            {
+                if (seed > firstDivergence.load(std::memory_order_relaxed))
+                {
+                    break;
+                }
+                if (findDivergence(generateCase<Variant>(seed)) != nullptr)
+                {
+                    u64 current = firstDivergence.load();
+                    while (seed < current && !firstDivergence.compare_exchange_weak(current, seed))
+                    {
+                    }
+                    break;
+                }
+            }
+        });
+    }
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    const u64 seed = firstDivergence.load();
+    if (seed == std::numeric_limits<u64>::max())
+    {
+        return true;
+    }
+
+    const Case<Variant> c = generateCase<Variant>(seed);
+    const Engine<Variant>& engine = *findDivergence(c);
+    printReproducer(variant, minimize(c, engine), engine);
+    return false;
+}
+
+} // namespace fuzz
+} // namespace c6502
+
+int main(int argc, char* argv[])
+{
+    using namespace c6502;
+    using namespace c6502::fuzz;
+
+    u64 caseCount = 100'000;
+    u64 firstSeed = 1;
+    unsigned threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const std::string option = argv[i];
+        const u64 value = std::strtoull(argv[i + 1], nullptr, 0);
+        if (option == "-n")
+        {
+            caseCount = value;
+        }
+        else if (option == "-s")
+        {
+            firstSeed = value;
+        }
+        else if (option == "-j")
+        {
+            threadCount = std::max<unsigned>(1, static_cast<unsigned>(value));
+        }
+        else
+        {
+            std::fprintf(stderr, "Usage: %s [-n cases] [-s first seed] [-j threads]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    const bool passed = fuzzVariant<Nmos6502>("Nmos6502", caseCount, firstSeed, threadCount) &&
+                        fuzzVariant<Nmos6502Undocumented>(
+                            "Nmos6502Undocumented", caseCount, firstSeed, threadCount) &&
+                        fuzzVariant<Cmos65C02>("Cmos65C02", caseCount, firstSeed, threadCount) &&
+                        fuzzVariant<Ricoh2A03>("Ricoh2A03", caseCount, firstSeed, threadCount);
+    if (!passed)
+    {
+        return 1;
+    }
+
+    std::printf("%llu cases, 4 variants, %zu engines, no divergence\n",
+                static_cast<unsigned long long>(caseCount),
+                std::size(engines<Nmos6502>));
+    return 0;
+}
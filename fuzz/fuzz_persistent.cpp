@@ -0,0 +1,170 @@
+/* Persistent mode fuzzing harness for 6502 code.
+ *
+ * Each input is loaded at startAddr and executed for a fixed cycle budget while the edges
+ * taken by the emulated program are recorded in the AFL coverage map. The harness keeps
+ * the same Cpu and Memory alive between inputs and only clears what the previous input
+ * touched, the bytes it was loaded to and the pages it stored to, so the per input cost is
+ * dominated by the emulation itself and every input starts from the same memory.
+ *
+ * Under afl-fuzz, build with afl-clang-fast++ to get the fork server and __AFL_LOOP. The
+ * coverage map is attached through __AFL_SHM_ID. Without AFL the harness runs every file
+ * given on the command line (or stdin) once and prints the number of map entries hit,
+ * which is handy for reproducing crashes.
+ */
+
+#include "c6502/c6502.h"
+#include "c6502/c6502Coverage.h"
+
+#include <sys/shm.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#ifndef __AFL_LOOP
+#define __AFL_LOOP(n) c6502::fuzz::singleIteration()
+#endif
+
+namespace c6502
+{
+namespace fuzz
+{
+static constexpr u16 startAddr = 0x1000;
+static constexpr s32 cycleBudget = 10'000;
+static constexpr std::size_t maxInputSize = Memory::MEM_MAX - startAddr;
+
+bool singleIteration()
+{
+    static bool done = false;
+    return !std::exchange(done, true);
+}
+
+/// Attaches the AFL shared memory map, or falls back to a private map
+u8* coverageMap()
+{
+    if (const char* shmId = std::getenv("__AFL_SHM_ID"))
+    {
+        void* map = shmat(std::atoi(shmId), nullptr, 0);
+        if (map != reinterpret_cast<void*>(-1))
+        {
+            return static_cast<u8*>(map);
+        }
+        std::perror("shmat");
+    }
+
+    static std::array<u8, EdgeCoverage::MAP_SIZE> privateMap{};
+    return privateMap.data();
+}
+
+/// Marks the pages an input stores to, so the next one can start from clean memory
+struct DirtyPageHooks : public NoHooks
+{
+    void onWrite(const u16 address, const u8 /*value*/)
+    {
+        dirtyPages.set(address >> 8);
+    }
+
+    std::bitset<256> dirtyPages;
+};
+
+using HarnessCpu = BasicCpu<Nmos6502, DirtyPageHooks>;
+
+class Harness
+{
+public:
+    Harness() : m_coverage(coverageMap())
+    {
+        m_memory.initialize();
+    }
+
+    /// Runs one input, invalid opcodes are a normal way for an input to end
+    void run(const u8* input, std::size_t size)
+    {
+        size = std::min(size, maxInputSize);
+        prepare(input, size);
+
+        m_cpu.run(cycleBudget, m_memory, m_coverage);
+    }
+
+    const EdgeCoverage& coverage() const
+    {
+        return m_coverage;
+    }
+
+private:
+    /// Undoes the previous input instead of clearing all 64 KB of memory
+    void prepare(const u8* input, const std::size_t size)
+    {
+        std::fill_n(&m_memory[startAddr], m_loadedSize, 0);
+        for (std::size_t page = 0; page < m_cpu.dirtyPages.size(); ++page)
+        {
+            if (m_cpu.dirtyPages.test(page))
+            {
+                std::fill_n(&m_memory[page * 256], 256, 0);
+            }
+        }
+        m_cpu.dirtyPages.reset();
+        std::copy_n(input, size, &m_memory[startAddr]);
+        m_loadedSize = size;
+
+        m_cpu.resetRegisters(startAddr);
+        m_coverage.resetEdge();
+    }
+
+    HarnessCpu m_cpu;
+    Memory m_memory;
+    EdgeCoverage m_coverage;
+    std::size_t m_loadedSize = 0;
+};
+
+std::vector<u8> readFile(const char* path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<u8>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+} // namespace fuzz
+} // namespace c6502
+
+int main(int argc, char* argv[])
+{
+    using namespace c6502;
+
+    fuzz::Harness harness;
+
+    if (argc > 1)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::vector<u8> input = fuzz::readFile(argv[i]);
+            harness.run(input.data(), input.size());
+        }
+
+        const u8* map = harness.coverage().bitmap;
+        const auto hits = std::count_if(map, map + EdgeCoverage::MAP_SIZE, [](u8 n) {
+            return n != 0;
+        });
+        std::fprintf(stderr, "%ld map entries hit\n", static_cast<long>(hits));
+        return 0;
+    }
+
+    // afl-fuzz rewinds stdin between iterations, so read it unbuffered
+    static std::array<u8, fuzz::maxInputSize> input;
+    while (__AFL_LOOP(100'000))
+    {
+        const ssize_t size = read(STDIN_FILENO, input.data(), input.size());
+        if (size >= 0)
+        {
+            harness.run(input.data(), static_cast<std::size_t>(size));
+        }
+    }
+
+    return 0;
+}
@@ -1,18 +1,48 @@
+#pragma once
+
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cstdint>
+#include <cstdio>
 #include <cstring>
-#include <iostream>
-#include <sstream>
+#include <iosfwd>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#ifndef C6502_LOGGING
+#define C6502_LOGGING 1
+#endif
 
 namespace c6502
 {
 using u32 = std::uint32_t;
 using s32 = std::int32_t;
+using u64 = std::uint64_t;
 
 using u8 = std::uint8_t;
 using u16 = std::uint16_t;
 
+/// Traces every fetch, read and instruction to stdout, set C6502_LOGGING=0 to compile it out
+static constexpr bool c_logging = C6502_LOGGING;
+
+namespace detail
+{
+/// Whether to trace, never while the CPU runs at compile time
+constexpr bool tracing()
+{
+    return c_logging && !std::is_constant_evaluated();
+}
+
+/// Writes a trace line, defined in c6502.cpp to keep iostream out of the core
+void traceAccess(const char* label, u16 address, unsigned value, const char* addressSuffix = "");
+void traceInstruction(std::string_view name);
+} // namespace detail
+
+struct EdgeCoverage;
+
 struct Memory
 {
     /* The first 256 byte page of memory ($0000-$00FF) is referred to as 'Zero Page'
@@ -26,30 +56,36 @@ struct Memory
     static constexpr std::uint32_t MEM_MAX = 64 * 1024;
     std::array<u8, MEM_MAX> data;
 
-    u8& operator[](const std::size_t pos)
+    constexpr u8& operator[](const std::size_t pos)
     {
         assert(pos < MEM_MAX);
-        return data.at(pos);
+        return data[pos];
     }
 
-    u8 operator[](const std::size_t pos) const
+    constexpr u8 operator[](const std::size_t pos) const
     {
         assert(pos < MEM_MAX);
-        return data.at(pos);
+        return data[pos];
+    }
+
+    /// How the CPU writes, any type with this and the const operator[] can be its Bus
+    constexpr void write(const u16 address, const u8 value)
+    {
+        data[address] = value;
     }
 
-    void initialize()
+    constexpr void initialize()
     {
         std::fill(std::begin(data), std::end(data), 0);
     }
 };
 
-inline bool operator==(const Memory& lhs, const Memory& rhs)
+constexpr bool operator==(const Memory& lhs, const Memory& rhs)
 {
     return std::equal(lhs.data.begin(), lhs.data.end(), rhs.data.begin());
 }
 
-inline bool operator!=(const Memory& lhs, const Memory& rhs)
+constexpr bool operator!=(const Memory& lhs, const Memory& rhs)
 {
     return !(lhs == rhs);
 }
@@ -57,29 +93,129 @@ inline bool operator!=(const Memory& lhs, const Memory& rhs)
 class InvalidOpCode : public std::runtime_error
 {
 public:
-    InvalidOpCode(const u8 opCode) : std::runtime_error("")
+    InvalidOpCode(const u8 opCode) : std::runtime_error(""), m_opCode(opCode)
     {
-        std::stringstream ss;
-        ss << "Invalid instruction: 0x" << std::hex << unsigned(opCode);
-        m_errorMessage = ss.str();
+        std::snprintf(m_errorMessage,
+                      sizeof(m_errorMessage),
+                      "Invalid instruction: 0x%x",
+                      unsigned(opCode));
     }
 
     virtual const char* what() const throw()
     {
-        return m_errorMessage.c_str();
+        return m_errorMessage;
+    }
+
+    u8 opCode() const
+    {
+        return m_opCode;
     }
 
 private:
-    std::string m_errorMessage;
+    u8 m_opCode;
+    char m_errorMessage[32];
 };
 
-struct Cpu
+/// Why Cpu::run returned
+enum class StopReason : u8
+{
+    CyclesExhausted,
+    InvalidOpCode,
+    HookRequested // The hooks asked to stop after an instruction
+};
+
+struct StopStatus
+{
+    StopReason reason;
+    u8 opCode;        // The invalid opcode
+    u16 PC;           // Address of the invalid opcode, otherwise where execution continues
+    u64 cycles;       // Cycles executed, including the fetch of an invalid opcode
+    u64 instructions; // Instructions executed, not counting an invalid opcode
+};
+
+constexpr bool operator==(const StopStatus& lhs, const StopStatus& rhs)
+{
+    return lhs.reason == rhs.reason && lhs.opCode == rhs.opCode && lhs.PC == rhs.PC &&
+           lhs.cycles == rhs.cycles && lhs.instructions == rhs.instructions;
+}
+
+/* CPU variants, passed to BasicCpu as a template parameter. Every variant gets its own
+ * opcode and dispatch tables built from these traits, so nothing is decided at run time.
+ */
+
+/// The original NMOS 6502 with the documented instruction set
+struct Nmos6502
+{
+    /// Whether the D flag makes ADC and SBC work in BCD, consulted once they are implemented
+    static constexpr bool c_decimalMode = true;
+
+    /// Whether JMP ($xxFF) fetches the high byte from $xx00, consulted once JMP is implemented
+    static constexpr bool c_jmpIndirectPageWrap = true;
+
+    /// The stable undocumented opcodes (LAX and the multi byte NOPs)
+    static constexpr bool c_undocumentedOpCodes = false;
+
+    /// The opcodes added by the 65C02
+    static constexpr bool c_cmosOpCodes = false;
+};
+
+/// NMOS 6502 executing the stable undocumented opcodes as well
+struct Nmos6502Undocumented : public Nmos6502
+{
+    static constexpr bool c_undocumentedOpCodes = true;
+};
+
+/// CMOS 65C02 with its extra opcodes and a JMP indirect that doesn't wrap within the page
+struct Cmos65C02 : public Nmos6502
+{
+    static constexpr bool c_jmpIndirectPageWrap = false;
+    static constexpr bool c_cmosOpCodes = true;
+};
+
+/// Ricoh 2A03 used in the NES, an NMOS 6502 without decimal mode
+struct Ricoh2A03 : public Nmos6502
+{
+    static constexpr bool c_decimalMode = false;
+};
+
+/// Addressing modes
+enum class AddrMode : u8
+{
+    Implied,
+    Immediate,
+    ZeroPage,
+    ZeroPageX,
+    ZeroPageY,
+    Absolute,
+    AbsoluteX,
+    AbsoluteY,
+    ZeroPageIndirect,  // (zp), 65C02 only
+    ZeroPageIndirectX, // (zp,X)
+    ZeroPageIndirectY, // (zp),Y
+    Accumulator,       // ASL A
+    Relative,          // Branches, a signed offset from the next instruction
+    Indirect,          // JMP (abs)
+    AbsoluteIndirectX  // JMP (abs,X), 65C02 only
+};
+
+/// Registers and opcodes, shared by every BasicCpu
+struct CpuState
 {
     static constexpr u16 c_nmi_vector = 0xFFFA;
     static constexpr u16 c_reset_vector = 0xFFFC;
     static constexpr u16 c_irq_vector = 0xFFFE;
     static constexpr u16 c_stack_top = 0xFF;
 
+    /// Bits of the flags in SR, the core only ever touches SR through these
+    static constexpr u8 c_carryFlag = 0b0000'0001;
+    static constexpr u8 c_zeroFlag = 0b0000'0010;
+    static constexpr u8 c_interruptFlag = 0b0000'0100;
+    static constexpr u8 c_decimalFlag = 0b0000'1000;
+    static constexpr u8 c_breakFlag = 0b0001'0000;
+    static constexpr u8 c_unusedFlag = 0b0010'0000;
+    static constexpr u8 c_overflowFlag = 0b0100'0000;
+    static constexpr u8 c_negativeFlag = 0b1000'0000;
+
     /// OP Codes
     enum OP : u8
     {
@@ -104,63 +240,36 @@ struct Cpu
         LDY_ZPX = 0xB4,
         LDY_ABS = 0xAC,
         LDY_ABSX = 0xBC,
+        // STA
+        STA_ZP = 0x85,
+        STA_ZPX = 0x95,
+        STA_ABS = 0x8D,
+        STA_ABSX = 0x9D,
+        STA_ABSY = 0x99,
+        STA_IND_ZPX = 0x81,
+        STA_IND_ZPY = 0x91,
+        // STX
+        STX_ZP = 0x86,
+        STX_ZPY = 0x96,
+        STX_ABS = 0x8E,
+        // STY
+        STY_ZP = 0x84,
+        STY_ZPX = 0x94,
+        STY_ABS = 0x8C,
         TXS = 0x9A,
-        NOP = 0xEA
+        NOP = 0xEA,
+        // 65C02
+        LDA_IND_ZP = 0xB2,
+        STA_IND_ZP = 0x92,
+        // Undocumented, LAX loads both A and X
+        LAX_ZP = 0xA7,
+        LAX_ZPY = 0xB7,
+        LAX_ABS = 0xAF,
+        LAX_ABSY = 0xBF,
+        LAX_IND_ZPX = 0xA3,
+        LAX_IND_ZPY = 0xB3
     };
 
-    static std::string OpCodeToString(const u8 opCode)
-    {
-        switch (opCode)
-        {
-            // LDA
-            case OP::LDA_IM:
-                return "LDA_IM";
-            case OP::LDA_ZP:
-                return "LDA_ZP";
-            case OP::LDA_ZPX:
-                return "LDA_ZPX";
-            case OP::LDA_ABS:
-                return "LDA_ABS";
-            case OP::LDA_ABSX:
-                return "LDA_ABSX";
-            case OP::LDA_ABSY:
-                return "LDA_ABSY";
-            case OP::LDA_IND_ZPX:
-                return "LDA_IND_ZPX";
-            case OP::LDA_IND_ZPY:
-                return "LDA_IND_ZPY";
-            // LDX
-            case OP::LDX_IM:
-                return "LDX_IM";
-            case OP::LDX_ZP:
-                return "LDX_ZP";
-            case OP::LDX_ZPY:
-                return "LDX_ZPY";
-            case OP::LDX_ABS:
-                return "LDX_ABS";
-            case OP::LDX_ABSY:
-                return "LDX_ABSY";
-            // LDY
-            case OP::LDY_IM:
-                return "LDY_IM";
-            case OP::LDY_ZP:
-                return "LDY_ZP";
-            case OP::LDY_ZPX:
-                return "LDY_ZPX";
-            case OP::LDY_ABS:
-                return "LDY_ABS";
-            case OP::LDY_ABSX:
-                return "LDY_ABSX";
-            //
-            case OP::TXS:
-                return "TXS";
-            case OP::NOP:
-                return "NOP";
-        }
-
-        throw InvalidOpCode(opCode);
-    }
-
     /* The value of program counter is modified automatically as instructions are executed.
      * The value of the program counter can be modified by executing a jump, a relative branch
      * or a subroutine call to another memory address or by returning from a subroutine or
@@ -180,7 +289,9 @@ struct Cpu
     u8 X; // Index register X
     u8 Y; // Index register Y
 
-    /// Processor status register flags
+    /* Processor status register flags. The bitfields are for reading and writing flags
+     * from outside, the core uses SR and the flag masks so it can run at compile time where
+     * only the last written member of a union may be read. */
     union
     {
         struct
@@ -200,56 +311,708 @@ struct Cpu
     /// Returns a string representation of the CPU's registers
     std::string toString() const;
 
+    /// Writes the string representation into buffer without allocating, like snprintf
+    int format(char* buffer, const std::size_t size) const;
+
     /// Resets the CPU and memory to their initialized state
     void reset(Memory& memory, const u16 startAddr);
 
+    /// Resets the CPU registers only, leaving memory untouched
+    constexpr void resetRegisters(const u16 startAddr)
+    {
+        PC = startAddr;
+        SP = c_stack_top;
+
+        A = 0;
+        X = 0;
+        Y = 0;
+
+        SR = 0;
+    }
+};
+
+namespace detail
+{
+/// Opcodes of the multi byte NOPs the undocumented NMOS opcode set adds, by addressing mode
+inline constexpr u8 c_nopImplied[] = {0x1A, 0x3A, 0x5A, 0x7A, 0xDA, 0xFA};
+inline constexpr u8 c_nopImmediate[] = {0x80, 0x82, 0x89, 0xC2, 0xE2};
+inline constexpr u8 c_nopZeroPage[] = {0x04, 0x44, 0x64};
+inline constexpr u8 c_nopZeroPageX[] = {0x14, 0x34, 0x54, 0x74, 0xD4, 0xF4};
+inline constexpr u8 c_nopAbsolute[] = {0x0C};
+inline constexpr u8 c_nopAbsoluteX[] = {0x1C, 0x3C, 0x5C, 0x7C, 0xDC, 0xFC};
+} // namespace detail
+
+/* Opcode metadata, the one table of what the opcodes of a variant are. It covers the
+ * documented NMOS instruction set, the 65C02 additions and, of the undocumented NMOS
+ * opcodes, the stable ones a variant can enable: LAX and the multi byte NOPs. It's more than
+ * the core executes so that any image can be disassembled, the opcode names the core goes
+ * by are derived from it.
+ */
+
+/// How an instruction passes control on
+enum class Flow : u8
+{
+    Next,         // To the next instruction
+    Branch,       // To the target or the next instruction
+    Jump,         // To the target only
+    JumpIndirect, // To an address read from memory
+    Call,         // To the target, and back to the next instruction
+    Return,       // To an address pulled from the stack
+    Stop,         // BRK, through the IRQ vector
+    Invalid       // Not an opcode of the variant
+};
+
+/// What an opcode is
+struct OpCodeInfo
+{
+    std::string_view mnemonic; // Empty for opcodes the variant doesn't have
+    AddrMode mode = AddrMode::Implied;
+    u8 length = 1; // Bytes, opcode included
+    Flow flow = Flow::Invalid;
+};
+
+namespace detail
+{
+constexpr u8 instructionLength(const AddrMode mode)
+{
+    switch (mode)
+    {
+        case AddrMode::Implied:
+        case AddrMode::Accumulator:
+        {
+            return 1;
+        }
+        case AddrMode::Absolute:
+        case AddrMode::AbsoluteX:
+        case AddrMode::AbsoluteY:
+        case AddrMode::Indirect:
+        case AddrMode::AbsoluteIndirectX:
+        {
+            return 3;
+        }
+        default:
+        {
+            return 2;
+        }
+    }
+}
+
+template <typename Variant>
+constexpr std::array<OpCodeInfo, 256> makeOpCodeInfo()
+{
+    std::array<OpCodeInfo, 256> info{};
+    const auto set = [&info](const u8 opCode,
+                             const std::string_view mnemonic,
+                             const AddrMode mode,
+                             const Flow flow = Flow::Next) {
+        info[opCode] = {mnemonic, mode, instructionLength(mode), flow};
+    };
+
+    // Documented NMOS instruction set
+    set(0x69, "ADC", AddrMode::Immediate);
+    set(0x65, "ADC", AddrMode::ZeroPage);
+    set(0x75, "ADC", AddrMode::ZeroPageX);
+    set(0x6D, "ADC", AddrMode::Absolute);
+    set(0x7D, "ADC", AddrMode::AbsoluteX);
+    set(0x79, "ADC", AddrMode::AbsoluteY);
+    set(0x61, "ADC", AddrMode::ZeroPageIndirectX);
+    set(0x71, "ADC", AddrMode::ZeroPageIndirectY);
+    set(0x29, "AND", AddrMode::Immediate);
+    set(0x25, "AND", AddrMode::ZeroPage);
+    set(0x35, "AND", AddrMode::ZeroPageX);
+    set(0x2D, "AND", AddrMode::Absolute);
+    set(0x3D, "AND", AddrMode::AbsoluteX);
+    set(0x39, "AND", AddrMode::AbsoluteY);
+    set(0x21, "AND", AddrMode::ZeroPageIndirectX);
+    set(0x31, "AND", AddrMode::ZeroPageIndirectY);
+    set(0x0A, "ASL", AddrMode::Accumulator);
+    set(0x06, "ASL", AddrMode::ZeroPage);
+    set(0x16, "ASL", AddrMode::ZeroPageX);
+    set(0x0E, "ASL", AddrMode::Absolute);
+    set(0x1E, "ASL", AddrMode::AbsoluteX);
+    set(0x90, "BCC", AddrMode::Relative, Flow::Branch);
+    set(0xB0, "BCS", AddrMode::Relative, Flow::Branch);
+    set(0xF0, "BEQ", AddrMode::Relative, Flow::Branch);
+    set(0x30, "BMI", AddrMode::Relative, Flow::Branch);
+    set(0xD0, "BNE", AddrMode::Relative, Flow::Branch);
+    set(0x10, "BPL", AddrMode::Relative, Flow::Branch);
+    set(0x50, "BVC", AddrMode::Relative, Flow::Branch);
+    set(0x70, "BVS", AddrMode::Relative, Flow::Branch);
+    set(0x24, "BIT", AddrMode::ZeroPage);
+    set(0x2C, "BIT", AddrMode::Absolute);
+    set(0x00, "BRK", AddrMode::Implied, Flow::Stop);
+    set(0x18, "CLC", AddrMode::Implied);
+    set(0xD8, "CLD", AddrMode::Implied);
+    set(0x58, "CLI", AddrMode::Implied);
+    set(0xB8, "CLV", AddrMode::Implied);
+    set(0xC9, "CMP", AddrMode::Immediate);
+    set(0xC5, "CMP", AddrMode::ZeroPage);
+    set(0xD5, "CMP", AddrMode::ZeroPageX);
+    set(0xCD, "CMP", AddrMode::Absolute);
+    set(0xDD, "CMP", AddrMode::AbsoluteX);
+    set(0xD9, "CMP", AddrMode::AbsoluteY);
+    set(0xC1, "CMP", AddrMode::ZeroPageIndirectX);
+    set(0xD1, "CMP", AddrMode::ZeroPageIndirectY);
+    set(0xE0, "CPX", AddrMode::Immediate);
+    set(0xE4, "CPX", AddrMode::ZeroPage);
+    set(0xEC, "CPX", AddrMode::Absolute);
+    set(0xC0, "CPY", AddrMode::Immediate);
+    set(0xC4, "CPY", AddrMode::ZeroPage);
+    set(0xCC, "CPY", AddrMode::Absolute);
+    set(0xC6, "DEC", AddrMode::ZeroPage);
+    set(0xD6, "DEC", AddrMode::ZeroPageX);
+    set(0xCE, "DEC", AddrMode::Absolute);
+    set(0xDE, "DEC", AddrMode::AbsoluteX);
+    set(0xCA, "DEX", AddrMode::Implied);
+    set(0x88, "DEY", AddrMode::Implied);
+    set(0x49, "EOR", AddrMode::Immediate);
+    set(0x45, "EOR", AddrMode::ZeroPage);
+    set(0x55, "EOR", AddrMode::ZeroPageX);
+    set(0x4D, "EOR", AddrMode::Absolute);
+    set(0x5D, "EOR", AddrMode::AbsoluteX);
+    set(0x59, "EOR", AddrMode::AbsoluteY);
+    set(0x41, "EOR", AddrMode::ZeroPageIndirectX);
+    set(0x51, "EOR", AddrMode::ZeroPageIndirectY);
+    set(0xE6, "INC", AddrMode::ZeroPage);
+    set(0xF6, "INC", AddrMode::ZeroPageX);
+    set(0xEE, "INC", AddrMode::Absolute);
+    set(0xFE, "INC", AddrMode::AbsoluteX);
+    set(0xE8, "INX", AddrMode::Implied);
+    set(0xC8, "INY", AddrMode::Implied);
+    set(0x4C, "JMP", AddrMode::Absolute, Flow::Jump);
+    set(0x6C, "JMP", AddrMode::Indirect, Flow::JumpIndirect);
+    set(0x20, "JSR", AddrMode::Absolute, Flow::Call);
+    set(0xA9, "LDA", AddrMode::Immediate);
+    set(0xA5, "LDA", AddrMode::ZeroPage);
+    set(0xB5, "LDA", AddrMode::ZeroPageX);
+    set(0xAD, "LDA", AddrMode::Absolute);
+    set(0xBD, "LDA", AddrMode::AbsoluteX);
+    set(0xB9, "LDA", AddrMode::AbsoluteY);
+    set(0xA1, "LDA", AddrMode::ZeroPageIndirectX);
+    set(0xB1, "LDA", AddrMode::ZeroPageIndirectY);
+    set(0xA2, "LDX", AddrMode::Immediate);
+    set(0xA6, "LDX", AddrMode::ZeroPage);
+    set(0xB6, "LDX", AddrMode::ZeroPageY);
+    set(0xAE, "LDX", AddrMode::Absolute);
+    set(0xBE, "LDX", AddrMode::AbsoluteY);
+    set(0xA0, "LDY", AddrMode::Immediate);
+    set(0xA4, "LDY", AddrMode::ZeroPage);
+    set(0xB4, "LDY", AddrMode::ZeroPageX);
+    set(0xAC, "LDY", AddrMode::Absolute);
+    set(0xBC, "LDY", AddrMode::AbsoluteX);
+    set(0x4A, "LSR", AddrMode::Accumulator);
+    set(0x46, "LSR", AddrMode::ZeroPage);
+    set(0x56, "LSR", AddrMode::ZeroPageX);
+    set(0x4E, "LSR", AddrMode::Absolute);
+    set(0x5E, "LSR", AddrMode::AbsoluteX);
+    set(0xEA, "NOP", AddrMode::Implied);
+    set(0x09, "ORA", AddrMode::Immediate);
+    set(0x05, "ORA", AddrMode::ZeroPage);
+    set(0x15, "ORA", AddrMode::ZeroPageX);
+    set(0x0D, "ORA", AddrMode::Absolute);
+    set(0x1D, "ORA", AddrMode::AbsoluteX);
+    set(0x19, "ORA", AddrMode::AbsoluteY);
+    set(0x01, "ORA", AddrMode::ZeroPageIndirectX);
+    set(0x11, "ORA", AddrMode::ZeroPageIndirectY);
+    set(0x48, "PHA", AddrMode::Implied);
+    set(0x08, "PHP", AddrMode::Implied);
+    set(0x68, "PLA", AddrMode::Implied);
+    set(0x28, "PLP", AddrMode::Implied);
+    set(0x2A, "ROL", AddrMode::Accumulator);
+    set(0x26, "ROL", AddrMode::ZeroPage);
+    set(0x36, "ROL", AddrMode::ZeroPageX);
+    set(0x2E, "ROL", AddrMode::Absolute);
+    set(0x3E, "ROL", AddrMode::AbsoluteX);
+    set(0x6A, "ROR", AddrMode::Accumulator);
+    set(0x66, "ROR", AddrMode::ZeroPage);
+    set(0x76, "ROR", AddrMode::ZeroPageX);
+    set(0x6E, "ROR", AddrMode::Absolute);
+    set(0x7E, "ROR", AddrMode::AbsoluteX);
+    set(0x40, "RTI", AddrMode::Implied, Flow::Return);
+    set(0x60, "RTS", AddrMode::Implied, Flow::Return);
+    set(0xE9, "SBC", AddrMode::Immediate);
+    set(0xE5, "SBC", AddrMode::ZeroPage);
+    set(0xF5, "SBC", AddrMode::ZeroPageX);
+    set(0xED, "SBC", AddrMode::Absolute);
+    set(0xFD, "SBC", AddrMode::AbsoluteX);
+    set(0xF9, "SBC", AddrMode::AbsoluteY);
+    set(0xE1, "SBC", AddrMode::ZeroPageIndirectX);
+    set(0xF1, "SBC", AddrMode::ZeroPageIndirectY);
+    set(0x38, "SEC", AddrMode::Implied);
+    set(0xF8, "SED", AddrMode::Implied);
+    set(0x78, "SEI", AddrMode::Implied);
+    set(0x85, "STA", AddrMode::ZeroPage);
+    set(0x95, "STA", AddrMode::ZeroPageX);
+    set(0x8D, "STA", AddrMode::Absolute);
+    set(0x9D, "STA", AddrMode::AbsoluteX);
+    set(0x99, "STA", AddrMode::AbsoluteY);
+    set(0x81, "STA", AddrMode::ZeroPageIndirectX);
+    set(0x91, "STA", AddrMode::ZeroPageIndirectY);
+    set(0x86, "STX", AddrMode::ZeroPage);
+    set(0x96, "STX", AddrMode::ZeroPageY);
+    set(0x8E, "STX", AddrMode::Absolute);
+    set(0x84, "STY", AddrMode::ZeroPage);
+    set(0x94, "STY", AddrMode::ZeroPageX);
+    set(0x8C, "STY", AddrMode::Absolute);
+    set(0xAA, "TAX", AddrMode::Implied);
+    set(0xA8, "TAY", AddrMode::Implied);
+    set(0xBA, "TSX", AddrMode::Implied);
+    set(0x8A, "TXA", AddrMode::Implied);
+    set(0x9A, "TXS", AddrMode::Implied);
+    set(0x98, "TYA", AddrMode::Implied);
+
+    if constexpr (Variant::c_cmosOpCodes)
+    {
+        set(0x80, "BRA", AddrMode::Relative, Flow::Jump);
+        set(0xDA, "PHX", AddrMode::Implied);
+        set(0x5A, "PHY", AddrMode::Implied);
+        set(0xFA, "PLX", AddrMode::Implied);
+        set(0x7A, "PLY", AddrMode::Implied);
+        set(0x64, "STZ", AddrMode::ZeroPage);
+        set(0x74, "STZ", AddrMode::ZeroPageX);
+        set(0x9C, "STZ", AddrMode::Absolute);
+        set(0x9E, "STZ", AddrMode::AbsoluteX);
+        set(0x14, "TRB", AddrMode::ZeroPage);
+        set(0x1C, "TRB", AddrMode::Absolute);
+        set(0x04, "TSB", AddrMode::ZeroPage);
+        set(0x0C, "TSB", AddrMode::Absolute);
+        set(0x1A, "INC", AddrMode::Accumulator);
+        set(0x3A, "DEC", AddrMode::Accumulator);
+        set(0x89, "BIT", AddrMode::Immediate);
+        set(0x34, "BIT", AddrMode::ZeroPageX);
+        set(0x3C, "BIT", AddrMode::AbsoluteX);
+        set(0x7C, "JMP", AddrMode::AbsoluteIndirectX, Flow::JumpIndirect);
+        set(0x12, "ORA", AddrMode::ZeroPageIndirect);
+        set(0x32, "AND", AddrMode::ZeroPageIndirect);
+        set(0x52, "EOR", AddrMode::ZeroPageIndirect);
+        set(0x72, "ADC", AddrMode::ZeroPageIndirect);
+        set(0x92, "STA", AddrMode::ZeroPageIndirect);
+        set(0xB2, "LDA", AddrMode::ZeroPageIndirect);
+        set(0xD2, "CMP", AddrMode::ZeroPageIndirect);
+        set(0xF2, "SBC", AddrMode::ZeroPageIndirect);
+    }
+
+    if constexpr (Variant::c_undocumentedOpCodes)
+    {
+        set(CpuState::OP::LAX_ZP, "LAX", AddrMode::ZeroPage);
+        set(CpuState::OP::LAX_ZPY, "LAX", AddrMode::ZeroPageY);
+        set(CpuState::OP::LAX_ABS, "LAX", AddrMode::Absolute);
+        set(CpuState::OP::LAX_ABSY, "LAX", AddrMode::AbsoluteY);
+        set(CpuState::OP::LAX_IND_ZPX, "LAX", AddrMode::ZeroPageIndirectX);
+        set(CpuState::OP::LAX_IND_ZPY, "LAX", AddrMode::ZeroPageIndirectY);
+
+        for (const u8 opCode : c_nopImplied)
+        {
+            set(opCode, "NOP", AddrMode::Implied);
+        }
+        for (const u8 opCode : c_nopImmediate)
+        {
+            set(opCode, "NOP", AddrMode::Immediate);
+        }
+        for (const u8 opCode : c_nopZeroPage)
+        {
+            set(opCode, "NOP", AddrMode::ZeroPage);
+        }
+        for (const u8 opCode : c_nopZeroPageX)
+        {
+            set(opCode, "NOP", AddrMode::ZeroPageX);
+        }
+        for (const u8 opCode : c_nopAbsolute)
+        {
+            set(opCode, "NOP", AddrMode::Absolute);
+        }
+        for (const u8 opCode : c_nopAbsoluteX)
+        {
+            set(opCode, "NOP", AddrMode::AbsoluteX);
+        }
+    }
+
+    return info;
+}
+} // namespace detail
+
+/// Metadata of every opcode of a variant
+template <typename Variant>
+inline constexpr std::array<OpCodeInfo, 256> c_opCodeInfo = detail::makeOpCodeInfo<Variant>();
+
+namespace detail
+{
+/// Mnemonics the core executes, in every addressing mode the variant has them in
+inline constexpr std::string_view c_executedMnemonics[] = {
+    "LDA", "LDX", "LDY", "LAX", "STA", "STX", "STY", "TXS", "NOP"};
+
+/// What OpCodeToString appends to the mnemonic for an addressing mode
+constexpr std::string_view modeSuffix(const AddrMode mode)
+{
+    switch (mode)
+    {
+        case AddrMode::Immediate:
+        {
+            return "IM";
+        }
+        case AddrMode::ZeroPage:
+        {
+            return "ZP";
+        }
+        case AddrMode::ZeroPageX:
+        {
+            return "ZPX";
+        }
+        case AddrMode::ZeroPageY:
+        {
+            return "ZPY";
+        }
+        case AddrMode::Absolute:
+        {
+            return "ABS";
+        }
+        case AddrMode::AbsoluteX:
+        {
+            return "ABSX";
+        }
+        case AddrMode::AbsoluteY:
+        {
+            return "ABSY";
+        }
+        case AddrMode::ZeroPageIndirect:
+        {
+            return "IND_ZP";
+        }
+        case AddrMode::ZeroPageIndirectX:
+        {
+            return "IND_ZPX";
+        }
+        case AddrMode::ZeroPageIndirectY:
+        {
+            return "IND_ZPY";
+        }
+        case AddrMode::Relative:
+        {
+            return "REL";
+        }
+        case AddrMode::Indirect:
+        {
+            return "IND";
+        }
+        case AddrMode::AbsoluteIndirectX:
+        {
+            return "IND_ABSX";
+        }
+        default:
+        {
+            return "";
+        }
+    }
+}
+
+/// The text of an opcode name, kept in a table of its own for the string_views to point at
+struct OpCodeName
+{
+    std::array<char, 16> text{};
+    std::size_t length = 0;
+};
+
+template <typename Variant>
+constexpr std::array<OpCodeName, 256> makeOpCodeNames()
+{
+    std::array<OpCodeName, 256> names{};
+    for (std::size_t opCode = 0; opCode < names.size(); ++opCode)
+    {
+        const OpCodeInfo& info = c_opCodeInfo<Variant>[opCode];
+        if (std::find(std::begin(c_executedMnemonics), std::end(c_executedMnemonics),
+                      info.mnemonic) == std::end(c_executedMnemonics))
+        {
+            continue;
+        }
+
+        OpCodeName& name = names[opCode];
+        const auto append = [&name](const std::string_view text) {
+            for (const char c : text)
+            {
+                name.text[name.length++] = c;
+            }
+        };
+        append(info.mnemonic);
+        if (!modeSuffix(info.mode).empty())
+        {
+            append("_");
+            append(modeSuffix(info.mode));
+        }
+    }
+    return names;
+}
+
+template <typename Variant>
+inline constexpr std::array<OpCodeName, 256> c_opCodeNameText = makeOpCodeNames<Variant>();
+
+template <typename Variant>
+constexpr std::array<std::string_view, 256> viewOpCodeNames()
+{
+    std::array<std::string_view, 256> views{};
+    for (std::size_t opCode = 0; opCode < views.size(); ++opCode)
+    {
+        const OpCodeName& name = c_opCodeNameText<Variant>[opCode];
+        views[opCode] = std::string_view(name.text.data(), name.length);
+    }
+    return views;
+}
+} // namespace detail
+
+/// Names of the opcodes a variant implements, e.g. LDA_IM, empty for the rest. They are
+/// derived from c_opCodeInfo, the one table of what the opcodes are.
+template <typename Variant>
+inline constexpr std::array<std::string_view, 256> c_opCodeNames =
+    detail::viewOpCodeNames<Variant>();
+
+/* Hooks are mixed into BasicCpu at compile time rather than called through virtual
+ * functions. A hook policy derives from NoHooks and hides the functions it is interested
+ * in, the ones it leaves alone are empty and compile away, so BasicCpu<NoHooks> runs the
+ * same loop as a CPU without hooks. The policy's state lives in the CPU object itself.
+ */
+struct NoHooks
+{
+    /// Called once the opcode of the instruction at address has been fetched
+    constexpr void preInstruction(const CpuState& /*cpu*/,
+                                  const u16 /*address*/,
+                                  const u8 /*opCode*/)
+    {
+    }
+
+    /// Called when the instruction at address has been executed
+    constexpr void postInstruction(const CpuState& /*cpu*/,
+                                   const u16 /*address*/,
+                                   const u8 /*opCode*/)
+    {
+    }
+
+    /// Called for every byte read from memory, opcode and operand fetches included
+    constexpr void onRead(const u16 /*address*/, const u8 /*value*/)
+    {
+    }
+
+    /// Called for every byte written to memory
+    constexpr void onWrite(const u16 /*address*/, const u8 /*value*/)
+    {
+    }
+
+    /// Checked after every instruction, run() and execute() return early when true
+    constexpr bool stopRequested() const
+    {
+        return false;
+    }
+};
+
+/* Timing policies, passed to BasicCpu as a template parameter. Both run the same
+ * instruction definitions and finish every instruction on the same cycle, they differ in
+ * what the bus and the cycle counter do in between.
+ */
+
+/// Every bus cycle is an access at the address the 6502 puts on the bus, dummy reads
+/// included, and the cycle counter moves with each access. For devices that watch the bus.
+struct CycleExact
+{
+    static constexpr bool c_cycleExact = true;
+};
+
+/// Only the accesses an instruction needs are made, and the instruction is charged its
+/// cycles in one go as it starts. For batch runs that don't look inside instructions.
+///
+/// On Memory without read hooks it's about as fast as CycleExact, not faster: the
+/// compiler drops dummy reads nothing sees and folds the per access counts into one add
+/// per instruction already. It saves time where reads can't be dropped, on buses with side
+/// effects or with onRead hooks, and those then also miss the dummy reads.
+struct Fast
+{
+    static constexpr bool c_cycleExact = false;
+};
+
+/* A CPU variant with a hook policy and a timing policy mixed in, running on a Bus: Memory
+ * or any type that reads with a const operator[] and writes with write(). The definitions
+ * are in c6502Impl.h.
+ *
+ * Everything but executeInfinite is constexpr, so a CPU can run 6502 code at compile time
+ * through run(), e.g. to build tables or to static_assert on ROM contents. execute() works
+ * too as long as it doesn't hit an invalid opcode. */
+template <typename Variant = Nmos6502,
+          typename Hooks = NoHooks,
+          typename Timing = CycleExact,
+          typename Bus = Memory>
+struct BasicCpu : public CpuState, public Hooks
+{
+    using VariantType = Variant;
+    using HooksType = Hooks;
+    using TimingType = Timing;
+
+    /// Returns the name of an opcode, throws InvalidOpCode for opcodes that aren't implemented
+    static constexpr std::string_view OpCodeToString(const u8 opCode)
+    {
+        if (!isValidOpCode(opCode))
+        {
+            throw InvalidOpCode(opCode);
+        }
+        return c_opCodeNames<Variant>[opCode];
+    }
+
+    /// Returns whether the opcode is implemented
+    static constexpr bool isValidOpCode(const u8 opCode)
+    {
+        return !c_opCodeNames<Variant>[opCode].empty();
+    }
+
     /// Reads a byte from specified address and increments the program counter
-    u8 fetchByte(s32& cycles, const Memory& memory, const bool log = true);
+    constexpr u8 fetchByte(const Bus& memory, const bool log = true);
 
     /// Reads a 16 bit word from specified address and increments the program counter
-    u16 fetchWord(s32& cycles, const Memory& memory);
+    constexpr u16 fetchWord(const Bus& memory);
 
     /// Reads a byte from address
-    u8 readByte(s32& cycles, const u16 address, const Memory& memory, const bool log = true);
+    constexpr u8 readByte(const u16 address, const Bus& memory, const bool log = true);
 
     /// Reads a 16 bit word from address
-    u16 readWord(s32& cycles, const u16 address, const Memory& memory);
-
-    void loadIntoRegister(u8& reg, const u8 value, const u8& zeroFlagReg);
-    void loadIntoRegister(u8& reg, const u8 value);
-
-    u8 readImmediate(s32& cycles, Memory& memory);
-    u8 readZeroPage(s32& cycles, Memory& memory);
-    u8 readZeroPageOffset(s32& cycles, Memory& memory, u8& offsetReg);
-    u8 readAbsolute(s32& cycles, Memory& memory);
-    u8 readAbsoluteOffset(s32& cycles, Memory& memory, u8& offsetReg); // TODO: Const offsetReg
-    u8 readZeroPageIndirectX(s32& cycles, Memory& memory, const u8& offsetReg);
-    u8 readZeroPageIndirectY(s32& cycles,
-                             Memory& memory,
-                             const u8& offsetReg,
-                             const bool alwaysAddExtraCycle = false);
+    constexpr u16 readWord(const u16 address, const Bus& memory);
+
+    /// Reads a 16 bit pointer from the zero page, the high byte of one at $FF comes from $00
+    constexpr u16 readZeroPageWord(const u8 address, const Bus& memory);
+
+    /// Writes a byte to address
+    constexpr void writeByte(const u16 address,
+                             const u8 value,
+                             Bus& memory,
+                             const bool log = true);
+
+    constexpr void loadIntoRegister(u8& reg, const u8 value, const u8& zeroFlagReg);
+    constexpr void loadIntoRegister(u8& reg, const u8 value);
+
+    constexpr u8 readImmediate(Bus& memory);
+    constexpr u8 readZeroPage(Bus& memory);
+    constexpr u8 readZeroPageOffset(Bus& memory, u8& offsetReg);
+    constexpr u8 readAbsolute(Bus& memory);
+    // TODO: Const offsetReg
+    constexpr u8 readAbsoluteOffset(Bus& memory, u8& offsetReg);
+    constexpr u8 readZeroPageIndirect(Bus& memory);
+    constexpr u8 readZeroPageIndirectX(Bus& memory, const u8& offsetReg);
+    constexpr u8 readZeroPageIndirectY(Bus& memory,
+                                       const u8& offsetReg,
+                                       const bool alwaysAddExtraCycle = false);
+
+    /// Fetches the operand of a store and returns the address it writes to. Indexed modes
+    /// always make the read that fixes up the high byte, a store can't take it back.
+    template <AddrMode mode>
+    constexpr u16 writeAddress(Bus& memory);
 
     /// Executes an instruction
-    void executeInstruction(const OP opCode, s32& cycles, Memory& memory);
+    constexpr void executeInstruction(const OP opCode, Bus& memory);
+
+    /// Executes an instruction, returns false instead of throwing for an invalid opcode
+    constexpr bool tryExecuteInstruction(const OP opCode, Bus& memory);
 
     /// Executes n cycles
-    s32 execute(s32 cycles, Memory& memory);
+    constexpr s32 execute(s32 cycles, Bus& memory);
+
+    /// Executes n cycles and records every taken edge in the coverage bitmap
+    constexpr s32 execute(s32 cycles, Bus& memory, EdgeCoverage& coverage);
+
+    /// Executes n cycles, stops at an invalid opcode instead of throwing
+    constexpr StopStatus run(s32 cycles, Bus& memory) noexcept;
+    constexpr StopStatus run(s32 cycles, Bus& memory, EdgeCoverage& coverage) noexcept;
+
+    /// Like run, with common instruction pairs executed as superinstructions
+    constexpr StopStatus runFused(s32 cycles, Bus& memory) noexcept;
+
+    /// Executes until the cycle counter reaches the deadline, for budgets of any length
+    constexpr StopStatus runUntil(u64 deadline, Bus& memory) noexcept;
 
     /// Executes in an infinite loop
-    void executeInfinite(Memory& memory);
+    void executeInfinite(Bus& memory);
+
+    /// Cycles executed since the CPU was created, a resetRegisters doesn't turn back time
+    constexpr u64 cycles() const
+    {
+        return m_cycles;
+    }
+
+    /// Moves the cycle counter forward by cycles executed elsewhere, e.g. a cached run
+    constexpr void advanceCycles(const u64 cycles)
+    {
+        m_cycles += cycles;
+    }
+
+private:
+    /// Reads the operand of an instruction in one of the addressing modes
+    template <AddrMode mode>
+    constexpr u8 readOperand(Bus& memory);
+
+    /// Instruction handlers
+    template <u8 CpuState::*reg, AddrMode mode>
+    constexpr void load(Bus& memory);
+    template <AddrMode mode>
+    constexpr void loadAX(Bus& memory);
+    template <u8 CpuState::*reg, AddrMode mode>
+    constexpr void store(Bus& memory);
+    template <AddrMode mode>
+    constexpr void nop(Bus& memory);
+    constexpr void transferXToStackPointer(Bus& memory);
+
+    /// Counts the cycle of a bus access when cycle exact, the fast timing charges it up front
+    constexpr void busCycle();
+
+    /// A read whose value is thrown away, made for the cycle it takes. The fast timing skips
+    /// it and only charges an extraCycle, one that isn't part of the instruction's base cycles.
+    constexpr void dummyRead(const u16 address,
+                             const Bus& memory,
+                             const bool extraCycle = false);
+
+    /// Executes an instruction, or a superinstruction when fused, and returns the number of
+    /// instructions executed, 0 for an invalid opcode
+    template <bool Fused>
+    constexpr u32 dispatch(const OP opCode, Bus& memory);
+
+    /// Whether the instruction being executed is followed by second and the deadline is
+    /// past the cycles it has left, so that the two run as one superinstruction
+    constexpr bool fusesWith(const OP second,
+                             const u16 operandBytes,
+                             const u64 cyclesLeft,
+                             const Bus& memory) const;
+
+    /// Fetches the opcode of the second instruction of a superinstruction
+    constexpr void fetchFusedOpCode(const OP second, const Bus& memory);
+
+    /// The deadline n cycles from now, now for no cycles
+    constexpr u64 deadlineIn(const s32 cycles) const
+    {
+        return cycles > 0 ? m_cycles + cycles : m_cycles;
+    }
+
+    template <typename Coverage, bool Fused = false>
+    constexpr StopStatus executeLoop(Bus& memory, Coverage& coverage) noexcept;
+
+    /* Time only moves forward: every cycle an instruction takes increments m_cycles, and
+     * the loop runs while m_cycles is short of m_deadline. Neither is reset with the
+     * registers and a 64 bit counter doesn't wrap in any simulation.
+     */
+    u64 m_cycles = 0;
+    u64 m_deadline = 0;
 };
 
-inline bool operator==(const Cpu& lhs, const Cpu& rhs)
+using Cpu = BasicCpu<Nmos6502>;
+using CpuUndocumented = BasicCpu<Nmos6502Undocumented>;
+using Cpu65C02 = BasicCpu<Cmos65C02>;
+using Cpu2A03 = BasicCpu<Ricoh2A03>;
+using FastCpu = BasicCpu<Nmos6502, NoHooks, Fast>;
+
+constexpr bool operator==(const CpuState& lhs, const CpuState& rhs)
 {
     return (lhs.PC == rhs.PC && lhs.SP == rhs.SP && lhs.A == rhs.A && lhs.X == rhs.X &&
             lhs.Y == rhs.Y && lhs.SR == rhs.SR);
 }
 
-inline bool operator!=(const Cpu& lhs, const Cpu& rhs)
+constexpr bool operator!=(const CpuState& lhs, const CpuState& rhs)
 {
     return !(lhs == rhs);
 }
 
-std::ostream& operator<<(std::ostream& os, Cpu const& cpu);
+std::ostream& operator<<(std::ostream& os, CpuState const& cpu);
 
 } // namespace c6502
+
+#include "c6502/c6502Impl.h"
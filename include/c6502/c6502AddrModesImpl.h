@@ -0,0 +1,191 @@
+#pragma once
+
+#include "c6502/c6502.h"
+
+namespace c6502
+{
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr u8 BasicCpu<Variant, Hooks, Timing, Bus>::readImmediate(Bus& memory)
+{
+    return fetchByte(memory);
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr u8 BasicCpu<Variant, Hooks, Timing, Bus>::readZeroPage(Bus& memory)
+{
+    const u8 ZPAddr = fetchByte(memory);
+    return readByte(ZPAddr, memory);
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr u8 BasicCpu<Variant, Hooks, Timing, Bus>::readZeroPageOffset(Bus& memory, u8& offsetReg)
+{
+    const u8 ZPAddr = fetchByte(memory);
+    dummyRead(ZPAddr, memory); // While the index is added
+
+    /// Should handle wrap around automatically since both are u8's
+    const u8 ZPAddrWithOffset = ZPAddr + offsetReg;
+
+    return readByte(ZPAddrWithOffset, memory);
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr u8 BasicCpu<Variant, Hooks, Timing, Bus>::readAbsolute(Bus& memory)
+{
+    const u16 absoluteAddr = fetchWord(memory);
+    return readByte(absoluteAddr, memory);
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr u8 BasicCpu<Variant, Hooks, Timing, Bus>::readAbsoluteOffset(Bus& memory, u8& offsetReg)
+{
+    const u16 absoluteAddr = fetchWord(memory);
+    const u16 effectiveAddr = absoluteAddr + offsetReg;
+
+    const bool crossedPageBoundary = (absoluteAddr & 0xFF00) != (effectiveAddr & 0xFF00);
+    if (crossedPageBoundary)
+    {
+        // The high byte is fixed up after a read from the same page
+        dummyRead((absoluteAddr & 0xFF00) | (effectiveAddr & 0x00FF), memory, true);
+    }
+
+    return readByte(effectiveAddr, memory);
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr u8 BasicCpu<Variant, Hooks, Timing, Bus>::readZeroPageIndirect(Bus& memory)
+{
+    const u8 ZPAddr = fetchByte(memory);
+    const u16 effectiveAddr = readZeroPageWord(ZPAddr, memory);
+
+    return readByte(effectiveAddr, memory);
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr u8 BasicCpu<Variant, Hooks, Timing, Bus>::readZeroPageIndirectX(Bus& memory,
+                                                                          const u8& offset)
+{
+    const u8 ZPAddr = fetchByte(memory);
+    dummyRead(ZPAddr, memory); // While the index is added
+    const u8 indirectAddr = ZPAddr + offset;
+
+    const u16 effectiveAddr = readZeroPageWord(indirectAddr, memory);
+
+    return readByte(effectiveAddr, memory);
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr u8 BasicCpu<Variant, Hooks, Timing, Bus>::readZeroPageIndirectY(
+    Bus& memory,
+    const u8& offset,
+    const bool alwaysAddExtraCycle)
+{
+    const u8 ZPAddr = fetchByte(memory);
+    const u16 indirectAddr = readZeroPageWord(ZPAddr, memory);
+    const u16 effectiveAddr = indirectAddr + offset;
+
+    const bool crossedPageBoundary = (indirectAddr & 0xFF00) != (effectiveAddr & 0xFF00);
+    if (crossedPageBoundary || alwaysAddExtraCycle)
+    {
+        // The high byte is fixed up after a read from the same page
+        dummyRead((indirectAddr & 0xFF00) | (effectiveAddr & 0x00FF), memory, true);
+    }
+
+    return readByte(effectiveAddr, memory);
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+template <AddrMode mode>
+constexpr u8 BasicCpu<Variant, Hooks, Timing, Bus>::readOperand(Bus& memory)
+{
+    if constexpr (mode == AddrMode::Immediate)
+    {
+        return readImmediate(memory);
+    }
+    else if constexpr (mode == AddrMode::ZeroPage)
+    {
+        return readZeroPage(memory);
+    }
+    else if constexpr (mode == AddrMode::ZeroPageX)
+    {
+        return readZeroPageOffset(memory, X);
+    }
+    else if constexpr (mode == AddrMode::ZeroPageY)
+    {
+        return readZeroPageOffset(memory, Y);
+    }
+    else if constexpr (mode == AddrMode::Absolute)
+    {
+        return readAbsolute(memory);
+    }
+    else if constexpr (mode == AddrMode::AbsoluteX)
+    {
+        return readAbsoluteOffset(memory, X);
+    }
+    else if constexpr (mode == AddrMode::AbsoluteY)
+    {
+        return readAbsoluteOffset(memory, Y);
+    }
+    else if constexpr (mode == AddrMode::ZeroPageIndirect)
+    {
+        return readZeroPageIndirect(memory);
+    }
+    else if constexpr (mode == AddrMode::ZeroPageIndirectX)
+    {
+        return readZeroPageIndirectX(memory, X);
+    }
+    else
+    {
+        static_assert(mode == AddrMode::ZeroPageIndirectY, "Addressing mode has no operand");
+        return readZeroPageIndirectY(memory, Y);
+    }
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+template <AddrMode mode>
+constexpr u16 BasicCpu<Variant, Hooks, Timing, Bus>::writeAddress(Bus& memory)
+{
+    if constexpr (mode == AddrMode::ZeroPage)
+    {
+        return fetchByte(memory);
+    }
+    else if constexpr (mode == AddrMode::ZeroPageX || mode == AddrMode::ZeroPageY)
+    {
+        const u8 ZPAddr = fetchByte(memory);
+        dummyRead(ZPAddr, memory); // While the index is added
+        return static_cast<u8>(ZPAddr + (mode == AddrMode::ZeroPageX ? X : Y));
+    }
+    else if constexpr (mode == AddrMode::Absolute)
+    {
+        return fetchWord(memory);
+    }
+    else if constexpr (mode == AddrMode::AbsoluteX || mode == AddrMode::AbsoluteY)
+    {
+        const u16 absoluteAddr = fetchWord(memory);
+        const u16 effectiveAddr = absoluteAddr + (mode == AddrMode::AbsoluteX ? X : Y);
+        dummyRead((absoluteAddr & 0xFF00) | (effectiveAddr & 0x00FF), memory);
+        return effectiveAddr;
+    }
+    else if constexpr (mode == AddrMode::ZeroPageIndirect)
+    {
+        const u8 ZPAddr = fetchByte(memory);
+        return readZeroPageWord(ZPAddr, memory);
+    }
+    else if constexpr (mode == AddrMode::ZeroPageIndirectX)
+    {
+        const u8 ZPAddr = fetchByte(memory);
+        dummyRead(ZPAddr, memory); // While the index is added
+        return readZeroPageWord(static_cast<u8>(ZPAddr + X), memory);
+    }
+    else
+    {
+        static_assert(mode == AddrMode::ZeroPageIndirectY, "Addressing mode can't be stored to");
+        const u8 ZPAddr = fetchByte(memory);
+        const u16 indirectAddr = readZeroPageWord(ZPAddr, memory);
+        const u16 effectiveAddr = indirectAddr + Y;
+        dummyRead((indirectAddr & 0xFF00) | (effectiveAddr & 0x00FF), memory);
+        return effectiveAddr;
+    }
+}
+
+} // namespace c6502
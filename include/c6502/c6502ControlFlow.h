@@ -0,0 +1,337 @@
+#pragma once
+
+#include "c6502/c6502.h"
+#include "c6502/c6502Disassembler.h"
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace c6502
+{
+/// A run of instructions that is only ever entered at its start and left at its end
+struct BasicBlock
+{
+    u16 start = 0;
+    u16 last = 0; // Address of the last instruction
+    u16 end = 0;  // Address after the last instruction
+    u16 instructions = 0;
+    Flow exit = Flow::Next; // Flow of the last instruction, Invalid when it runs into one
+    std::array<u16, 2> successors{};
+    u8 successorCount = 0;
+    bool loopHeader = false; // Target of a back edge
+
+    constexpr bool hasSuccessor(const u16 address) const
+    {
+        return (successorCount > 0 && successors[0] == address) ||
+               (successorCount > 1 && successors[1] == address);
+    }
+};
+
+/* Basic blocks and control flow graph of the code reachable from a set of entry points.
+ *
+ * The code is found by a CodeMap trace, every branch, jump and call target and every
+ * instruction after a branch, call or end of flow then starts a block. A block's
+ * successors are the blocks it can pass control to directly: returns, BRK and JMP (abs,X)
+ * have none, calls have both the subroutine and the instruction after the call.
+ *
+ * Loop headers are the targets of back edges found by a depth first search from the entry
+ * blocks, so they're the places a program spins in. Pages holding code and pages the code
+ * reads or writes through absolute and zero page operands are recorded separately, a
+ * page may be both.
+ *
+ * The analysis runs once, before execution, and tells execution engines what to prepare:
+ * which blocks to translate or cache and which loops may be idle loops.
+ */
+template <typename Variant = Nmos6502>
+class ControlFlowGraph
+{
+public:
+    /// Analyzes the code reachable from the NMI, reset and IRQ vectors
+    explicit ControlFlowGraph(const Memory& memory)
+        : ControlFlowGraph(memory,
+                           {readPointer(memory, CpuState::c_nmi_vector),
+                            readPointer(memory, CpuState::c_reset_vector),
+                            readPointer(memory, CpuState::c_irq_vector)})
+    {
+    }
+
+    ControlFlowGraph(const Memory& memory, const std::vector<u16>& entries)
+    {
+        auto map = std::make_unique<CodeMap<Variant>>();
+        for (const u16 entry : entries)
+        {
+            map->addEntry(entry);
+        }
+        map->trace(memory);
+
+        findLeaders(memory, *map, entries);
+        buildBlocks(memory, *map);
+        findLoopHeaders(entries);
+    }
+
+    /// Blocks in address order
+    const std::vector<BasicBlock>& blocks() const
+    {
+        return m_blocks;
+    }
+
+    /// The block starting at address, nullptr when no block does
+    const BasicBlock* blockAt(const u16 address) const
+    {
+        const auto block = std::lower_bound(
+            m_blocks.begin(), m_blocks.end(), address, [](const BasicBlock& b, const u16 a) {
+                return b.start < a;
+            });
+        return block != m_blocks.end() && block->start == address ? &*block : nullptr;
+    }
+
+    /// Start addresses of the loop headers, in address order
+    std::vector<u16> loopHeaders() const
+    {
+        std::vector<u16> headers;
+        for (const BasicBlock& block : m_blocks)
+        {
+            if (block.loopHeader)
+            {
+                headers.push_back(block.start);
+            }
+        }
+        return headers;
+    }
+
+    /// Whether a byte of the page belongs to an instruction
+    bool isCodePage(const u8 page) const
+    {
+        return m_codePages.test(page);
+    }
+
+    /// Whether an instruction reads or writes the page through its operand
+    bool isDataPage(const u8 page) const
+    {
+        return m_dataPages.test(page);
+    }
+
+private:
+    /// Where the instruction can pass control to, the next instruction included
+    static u8 successorsOf(const Memory& memory,
+                           const Instruction& instruction,
+                           std::array<u16, 2>& successors)
+    {
+        switch (instruction.info.flow)
+        {
+            case Flow::Next:
+            {
+                successors[0] = instruction.nextAddress();
+                return 1;
+            }
+            case Flow::Branch:
+            case Flow::Call:
+            {
+                successors[0] = instruction.target();
+                successors[1] = instruction.nextAddress();
+                return 2;
+            }
+            case Flow::Jump:
+            {
+                successors[0] = instruction.target();
+                return 1;
+            }
+            case Flow::JumpIndirect:
+            {
+                if (instruction.info.mode != AddrMode::Indirect)
+                {
+                    return 0;
+                }
+                successors[0] = readJumpPointer<Variant>(memory, instruction.operand);
+                return 1;
+            }
+            default:
+            {
+                return 0;
+            }
+        }
+    }
+
+    void findLeaders(const Memory& memory,
+                     const CodeMap<Variant>& map,
+                     const std::vector<u16>& entries)
+    {
+        for (const u16 entry : entries)
+        {
+            m_leaders.set(entry);
+        }
+
+        map.forEachInstruction(memory, [&](const Instruction& instruction) {
+            for (u8 i = 0; i < instruction.info.length; ++i)
+            {
+                m_codePages.set(static_cast<u16>(instruction.address + i) >> 8);
+            }
+            markDataPages(instruction);
+
+            if (instruction.info.flow == Flow::Next)
+            {
+                return;
+            }
+            std::array<u16, 2> successors{};
+            const u8 count = successorsOf(memory, instruction, successors);
+            for (u8 i = 0; i < count; ++i)
+            {
+                m_leaders.set(successors[i]);
+            }
+            m_leaders.set(instruction.nextAddress());
+        });
+    }
+
+    void markDataPages(const Instruction& instruction)
+    {
+        const u16 operand = instruction.operand;
+        switch (instruction.info.mode)
+        {
+            case AddrMode::ZeroPage:
+            case AddrMode::ZeroPageX:
+            case AddrMode::ZeroPageY:
+            case AddrMode::ZeroPageIndirect:
+            case AddrMode::ZeroPageIndirectX:
+            case AddrMode::ZeroPageIndirectY:
+            {
+                m_dataPages.set(0);
+                break;
+            }
+            case AddrMode::Absolute:
+            {
+                if (instruction.info.flow == Flow::Next)
+                {
+                    m_dataPages.set(operand >> 8);
+                }
+                break;
+            }
+            case AddrMode::Indirect:
+            case AddrMode::AbsoluteIndirectX:
+            {
+                m_dataPages.set(operand >> 8);
+                break;
+            }
+            case AddrMode::AbsoluteX:
+            case AddrMode::AbsoluteY:
+            {
+                // The index can carry into the next page
+                m_dataPages.set(operand >> 8);
+                m_dataPages.set(static_cast<u16>(operand + 0xFF) >> 8);
+                break;
+            }
+            default:
+            {
+                break;
+            }
+        }
+    }
+
+    void buildBlocks(const Memory& memory, const CodeMap<Variant>& map)
+    {
+        for (std::size_t leader = 0; leader < Memory::MEM_MAX; ++leader)
+        {
+            if (!m_leaders.test(leader) || !map.isInstructionStart(static_cast<u16>(leader)))
+            {
+                continue;
+            }
+
+            BasicBlock block;
+            block.start = static_cast<u16>(leader);
+            u16 address = block.start;
+            while (true)
+            {
+                const Instruction instruction = decode<Variant>(memory, address);
+                block.last = address;
+                block.end = instruction.nextAddress();
+                block.instructions++;
+                block.exit = instruction.info.flow;
+                address = block.end;
+
+                if (instruction.info.flow != Flow::Next)
+                {
+                    block.successorCount = successorsOf(memory, instruction, block.successors);
+                    break;
+                }
+                if (!map.isInstructionStart(address))
+                {
+                    // Runs into an invalid opcode
+                    block.exit = Flow::Invalid;
+                    break;
+                }
+                if (m_leaders.test(address))
+                {
+                    block.successors[0] = address;
+                    block.successorCount = 1;
+                    break;
+                }
+            }
+            m_blocks.push_back(block);
+        }
+    }
+
+    /// Marks the targets of the back edges of a depth first search from the entries
+    void findLoopHeaders(const std::vector<u16>& entries)
+    {
+        enum class Color : u8
+        {
+            White,
+            Gray,
+            Black
+        };
+        std::vector<Color> colors(m_blocks.size(), Color::White);
+        std::vector<std::pair<std::size_t, u8>> stack; // Block and next successor to visit
+
+        const auto indexOf = [this](const u16 address) {
+            return static_cast<std::size_t>(blockAt(address) - m_blocks.data());
+        };
+
+        for (const u16 entry : entries)
+        {
+            if (blockAt(entry) == nullptr || colors[indexOf(entry)] != Color::White)
+            {
+                continue;
+            }
+            colors[indexOf(entry)] = Color::Gray;
+            stack.emplace_back(indexOf(entry), 0);
+
+            while (!stack.empty())
+            {
+                auto& [index, next] = stack.back();
+                const BasicBlock& block = m_blocks[index];
+                if (next == block.successorCount)
+                {
+                    colors[index] = Color::Black;
+                    stack.pop_back();
+                    continue;
+                }
+
+                const u16 successor = block.successors[next++];
+                if (blockAt(successor) == nullptr)
+                {
+                    continue;
+                }
+                const std::size_t successorIndex = indexOf(successor);
+                if (colors[successorIndex] == Color::Gray)
+                {
+                    m_blocks[successorIndex].loopHeader = true;
+                }
+                else if (colors[successorIndex] == Color::White)
+                {
+                    colors[successorIndex] = Color::Gray;
+                    stack.emplace_back(successorIndex, 0);
+                }
+            }
+        }
+    }
+
+    std::vector<BasicBlock> m_blocks;
+    std::bitset<Memory::MEM_MAX> m_leaders;
+    std::bitset<256> m_codePages;
+    std::bitset<256> m_dataPages;
+};
+
+} // namespace c6502
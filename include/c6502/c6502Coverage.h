@@ -0,0 +1,63 @@
+#pragma once
+
+#include "c6502/c6502.h"
+
+#include <algorithm>
+
+namespace c6502
+{
+/* Edge coverage in the format used by AFL.
+ *
+ * Every time execution moves from one instruction to the next the edge between the two
+ * program counters is hashed into a 64 KB map of 8 bit hit counters:
+ *
+ *   cur = hash(PC)
+ *   map[cur ^ prev]++
+ *   prev = cur >> 1
+ *
+ * The shift keeps A -> B and B -> A apart as well as tight A -> A loops. The hash of the
+ * program counter is the one used by AFL's QEMU mode.
+ *
+ * The map is not owned, it is usually the shared memory segment handed over by afl-fuzz
+ * through the __AFL_SHM_ID environment variable.
+ */
+struct EdgeCoverage
+{
+    static constexpr std::uint32_t MAP_SIZE = 64 * 1024;
+
+    explicit EdgeCoverage(u8* map) : bitmap(map)
+    {
+    }
+
+    /// Spreads the program counter over the whole map
+    static constexpr u16 location(const u16 PC)
+    {
+        return static_cast<u16>((PC >> 4) ^ (PC << 8));
+    }
+
+    /// Records the edge from the previously visited instruction to the one at PC
+    void visit(const u16 PC)
+    {
+        const u16 currentLocation = location(PC);
+        bitmap[currentLocation ^ previousLocation]++;
+        previousLocation = currentLocation >> 1;
+    }
+
+    /// Forgets the previous location so that the next input starts with a fresh edge
+    void resetEdge()
+    {
+        previousLocation = 0;
+    }
+
+    /// Clears all hit counters, not needed under afl-fuzz which clears the map itself
+    void clear()
+    {
+        std::fill(bitmap, bitmap + MAP_SIZE, 0);
+        resetEdge();
+    }
+
+    u8* bitmap;
+    u16 previousLocation = 0;
+};
+
+} // namespace c6502
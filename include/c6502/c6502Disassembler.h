@@ -0,0 +1,253 @@
+#pragma once
+
+#include "c6502/c6502.h"
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <string_view>
+
+namespace c6502
+{
+/* Decoding and disassembly of 6502 code in memory.
+ *
+ * Instructions are described by c_opCodeInfo from c6502.h, which knows more opcodes than
+ * the core executes, so any image can be disassembled. Decoding reads
+ * memory and never allocates: decode() and Decoder yield one Instruction at a time,
+ * format() turns one into text and CodeMap follows the control flow from the vectors to
+ * find which bytes are code.
+ */
+
+/// Reads a little endian pointer, e.g. a vector
+constexpr u16 readPointer(const Memory& memory, const u16 address)
+{
+    return static_cast<u16>(memory[address] | (memory[static_cast<u16>(address + 1)] << 8));
+}
+
+/// Reads the pointer of JMP (abs) like the variant does
+template <typename Variant>
+constexpr u16 readJumpPointer(const Memory& memory, const u16 pointer)
+{
+    if constexpr (Variant::c_jmpIndirectPageWrap)
+    {
+        const u16 high = (pointer & 0xFF00) | ((pointer + 1) & 0x00FF);
+        return static_cast<u16>(memory[pointer] | (memory[high] << 8));
+    }
+    return readPointer(memory, pointer);
+}
+
+/// An instruction decoded from memory
+struct Instruction
+{
+    u16 address = 0;
+    u8 opCode = 0;
+    u16 operand = 0; // The operand bytes, little endian, zero when there are none
+    OpCodeInfo info;
+
+    constexpr bool isValid() const
+    {
+        return info.flow != Flow::Invalid;
+    }
+
+    constexpr u16 nextAddress() const
+    {
+        return static_cast<u16>(address + info.length);
+    }
+
+    /// Where a branch, jump or call goes, the operand for the other modes
+    constexpr u16 target() const
+    {
+        if (info.mode == AddrMode::Relative)
+        {
+            return static_cast<u16>(nextAddress() + static_cast<std::int8_t>(operand));
+        }
+        return operand;
+    }
+};
+
+/// Decodes the instruction at address, operands wrap around the end of memory
+template <typename Variant = Nmos6502>
+constexpr Instruction decode(const Memory& memory, const u16 address)
+{
+    Instruction instruction;
+    instruction.address = address;
+    instruction.opCode = memory[address];
+    instruction.info = c_opCodeInfo<Variant>[instruction.opCode];
+
+    if (instruction.info.length > 1)
+    {
+        instruction.operand = memory[static_cast<u16>(address + 1)];
+    }
+    if (instruction.info.length > 2)
+    {
+        instruction.operand |= memory[static_cast<u16>(address + 2)] << 8;
+    }
+    return instruction;
+}
+
+/// Decodes instructions one after the other, e.g. to sweep a whole image
+template <typename Variant = Nmos6502>
+class Decoder
+{
+public:
+    constexpr Decoder(const Memory& memory, const u16 address)
+        : m_memory(memory), m_address(address)
+    {
+    }
+
+    /// Address of the instruction next() returns
+    constexpr u16 address() const
+    {
+        return m_address;
+    }
+
+    constexpr Instruction next()
+    {
+        const Instruction instruction = decode<Variant>(m_memory, m_address);
+        m_address = instruction.nextAddress();
+        return instruction;
+    }
+
+private:
+    const Memory& m_memory;
+    u16 m_address;
+};
+
+/// Buffer size format() never needs more than
+static constexpr std::size_t c_formatBufferSize = 16;
+
+/// Writes an instruction as assembly, e.g. "LDA ($12),Y", and returns the length like
+/// snprintf. Invalid opcodes are written as a ".byte" directive.
+int format(const Instruction& instruction, char* buffer, std::size_t size);
+
+/* Which bytes of memory are code, found by following the control flow of the program.
+ *
+ * Tracing starts at the entry points and follows every instruction it reaches: both ways
+ * of a branch, the target and return of a call and the targets of jumps. JMP (abs) is
+ * followed through the pointer memory holds at the time of the trace, JMP (abs,X) and
+ * returns are not followed. Invalid opcodes end a path. Every byte is decoded at most
+ * once, so a whole 64 KB image takes a fraction of a millisecond.
+ *
+ * The map holds its work list, so it is better allocated on the heap.
+ */
+template <typename Variant = Nmos6502>
+class CodeMap
+{
+public:
+    /// Queues an address to trace from
+    void addEntry(const u16 address)
+    {
+        if (!m_queued.test(address))
+        {
+            m_queued.set(address);
+            m_pending[m_pendingCount++] = address;
+        }
+    }
+
+    /// Queues the addresses the NMI, reset and IRQ vectors point to
+    void addVectors(const Memory& memory)
+    {
+        addEntry(readPointer(memory, CpuState::c_nmi_vector));
+        addEntry(readPointer(memory, CpuState::c_reset_vector));
+        addEntry(readPointer(memory, CpuState::c_irq_vector));
+    }
+
+    /// Follows the control flow from every queued address
+    void trace(const Memory& memory)
+    {
+        while (m_pendingCount > 0)
+        {
+            traceFrom(memory, m_pending[--m_pendingCount]);
+        }
+    }
+
+    bool isInstructionStart(const u16 address) const
+    {
+        return m_starts.test(address);
+    }
+
+    /// Whether the byte belongs to an instruction that was reached
+    bool isCode(const u16 address) const
+    {
+        return m_code.test(address);
+    }
+
+    std::size_t instructionCount() const
+    {
+        return m_starts.count();
+    }
+
+    /// Calls function with every instruction found, in address order
+    template <typename Function>
+    void forEachInstruction(const Memory& memory, Function&& function) const
+    {
+        for (std::size_t address = 0; address < Memory::MEM_MAX; ++address)
+        {
+            if (m_starts.test(address))
+            {
+                function(decode<Variant>(memory, static_cast<u16>(address)));
+            }
+        }
+    }
+
+private:
+    void traceFrom(const Memory& memory, u16 address)
+    {
+        while (!m_starts.test(address))
+        {
+            const Instruction instruction = decode<Variant>(memory, address);
+            if (!instruction.isValid())
+            {
+                return;
+            }
+
+            m_starts.set(address);
+            for (u8 i = 0; i < instruction.info.length; ++i)
+            {
+                m_code.set(static_cast<u16>(address + i));
+            }
+
+            switch (instruction.info.flow)
+            {
+                case Flow::Branch:
+                case Flow::Call:
+                {
+                    addEntry(instruction.target());
+                    break;
+                }
+                case Flow::Jump:
+                {
+                    address = instruction.target();
+                    continue;
+                }
+                case Flow::JumpIndirect:
+                {
+                    if (instruction.info.mode == AddrMode::Indirect)
+                    {
+                        addEntry(readJumpPointer<Variant>(memory, instruction.operand));
+                    }
+                    return;
+                }
+                case Flow::Return:
+                case Flow::Stop:
+                case Flow::Invalid:
+                {
+                    return;
+                }
+                case Flow::Next:
+                {
+                    break;
+                }
+            }
+            address = instruction.nextAddress();
+        }
+    }
+
+    std::bitset<Memory::MEM_MAX> m_starts;
+    std::bitset<Memory::MEM_MAX> m_code;
+    std::bitset<Memory::MEM_MAX> m_queued;
+    std::array<u16, Memory::MEM_MAX> m_pending{};
+    std::size_t m_pendingCount = 0;
+};
+
+} // namespace c6502
@@ -0,0 +1,823 @@
+#pragma once
+
+/* Definitions of BasicCpu's members, included at the end of c6502.h. They have to be in
+ * a header for the CPU to run at compile time.
+ */
+
+#include "c6502/c6502.h"
+#include "c6502/c6502Coverage.h"
+
+namespace c6502
+{
+namespace detail
+{
+/// Stand-in for EdgeCoverage when coverage is off, compiles away entirely
+struct NoCoverage
+{
+    constexpr void visit(const u16 /*PC*/)
+    {
+    }
+};
+
+inline s32 throwOnInvalidOpCode(const StopStatus& status)
+{
+    if (status.reason == StopReason::InvalidOpCode)
+    {
+        throw InvalidOpCode(status.opCode);
+    }
+    return static_cast<s32>(status.cycles);
+}
+
+/// Cycles of every opcode when no page is crossed, measured by running it cycle exact
+template <typename Variant>
+constexpr std::array<u8, 256> measureOpCodeCycles();
+
+/// What the fast timing charges an instruction as it starts, 1 for an invalid opcode
+template <typename Variant>
+inline constexpr std::array<u8, 256> c_opCodeCycles = measureOpCodeCycles<Variant>();
+} // namespace detail
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr u8 BasicCpu<Variant, Hooks, Timing, Bus>::fetchByte(const Bus& memory, const bool log)
+{
+    const u8 data = memory[PC];
+    this->onRead(PC, data);
+    if (detail::tracing() && log)
+    {
+        detail::traceAccess("FetchB: ", PC, data);
+    }
+
+    PC++;
+    busCycle();
+
+    return data;
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr u16 BasicCpu<Variant, Hooks, Timing, Bus>::fetchWord(const Bus& memory)
+{
+    const bool log = false;
+    const u8 lowByte = fetchByte(memory, log);
+    const u8 highByte = fetchByte(memory, log);
+    const u16 data = (highByte << 8) | lowByte;
+
+    if (detail::tracing())
+    {
+        detail::traceAccess("FetchW: ", PC, data, "+1");
+    }
+
+    return data;
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr u8 BasicCpu<Variant, Hooks, Timing, Bus>::readByte(const u16 address,
+                                                             const Bus& memory,
+                                                             const bool log)
+{
+    const u8 data = memory[address];
+    this->onRead(address, data);
+    if (detail::tracing() && log)
+    {
+        detail::traceAccess("ReadB : ", address, data);
+    }
+    busCycle();
+
+    return data;
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr u16 BasicCpu<Variant, Hooks, Timing, Bus>::readWord(const u16 address, const Bus& memory)
+{
+    const bool log = false;
+    const u8 lowByte = readByte(address, memory, log);
+    const u8 highByte = readByte(address + 1, memory, log);
+    const u16 data = (highByte << 8) | lowByte;
+
+    if (detail::tracing())
+    {
+        detail::traceAccess("ReadW : ", address, data);
+    }
+
+    return data;
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr u16 BasicCpu<Variant, Hooks, Timing, Bus>::readZeroPageWord(const u8 address,
+                                                                      const Bus& memory)
+{
+    const bool log = false;
+    const u8 lowByte = readByte(address, memory, log);
+    const u8 highByte = readByte(static_cast<u8>(address + 1), memory, log);
+    const u16 data = (highByte << 8) | lowByte;
+
+    if (detail::tracing())
+    {
+        detail::traceAccess("ReadW : ", address, data);
+    }
+
+    return data;
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr void BasicCpu<Variant, Hooks, Timing, Bus>::writeByte(const u16 address,
+                                                                const u8 value,
+                                                                Bus& memory,
+                                                                const bool log)
+{
+    memory.write(address, value);
+    this->onWrite(address, value);
+    if (detail::tracing() && log)
+    {
+        detail::traceAccess("WriteB: ", address, value);
+    }
+    busCycle();
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr void BasicCpu<Variant, Hooks, Timing, Bus>::busCycle()
+{
+    if constexpr (Timing::c_cycleExact)
+    {
+        m_cycles++;
+    }
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr void BasicCpu<Variant, Hooks, Timing, Bus>::dummyRead(const u16 address,
+                                                                const Bus& memory,
+                                                                const bool extraCycle)
+{
+    if constexpr (Timing::c_cycleExact)
+    {
+        readByte(address, memory);
+    }
+    else if (extraCycle)
+    {
+        m_cycles++;
+    }
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr void BasicCpu<Variant, Hooks, Timing, Bus>::loadIntoRegister(u8& reg,
+                                                                       const u8 value,
+                                                                       const u8& zeroFlagReg)
+{
+    reg = value;
+    const u8 zero = (zeroFlagReg == 0x00) ? c_zeroFlag : 0;
+    const u8 negative = reg & c_negativeFlag;
+    SR = (SR & ~(c_zeroFlag | c_negativeFlag)) | zero | negative;
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr void BasicCpu<Variant, Hooks, Timing, Bus>::loadIntoRegister(u8& reg, const u8 value)
+{
+    loadIntoRegister(reg, value, reg);
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr void BasicCpu<Variant, Hooks, Timing, Bus>::executeInstruction(const OP opCode,
+                                                                         Bus& memory)
+{
+    if (!tryExecuteInstruction(opCode, memory))
+    {
+        throw InvalidOpCode(opCode);
+    }
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr bool BasicCpu<Variant, Hooks, Timing, Bus>::tryExecuteInstruction(const OP opCode,
+                                                                            Bus& memory)
+{
+    return dispatch<false>(opCode, memory) != 0;
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr bool BasicCpu<Variant, Hooks, Timing, Bus>::fusesWith(const OP second,
+                                                                const u16 operandBytes,
+                                                                const u64 cyclesLeft,
+                                                                const Bus& memory) const
+{
+    // The fast timing has charged the first instruction in full already
+    const u64 firstEnd = Timing::c_cycleExact ? m_cycles + cyclesLeft : m_cycles;
+    return firstEnd < m_deadline &&
+           memory[static_cast<u16>(PC + operandBytes)] == second;
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr void BasicCpu<Variant, Hooks, Timing, Bus>::fetchFusedOpCode(const OP second,
+                                                                       const Bus& memory)
+{
+    fetchByte(memory);
+    if constexpr (!Timing::c_cycleExact)
+    {
+        m_cycles += detail::c_opCodeCycles<Variant>[second];
+    }
+    if (detail::tracing())
+    {
+        detail::traceInstruction(OpCodeToString(second));
+    }
+}
+
+/* Superinstructions are the pairs the 16 bit load idiom (LDA lo, LDX hi), stack setup
+ * (LDX #$FF, TXS), padding (NOP, NOP) and setting or copying a variable (LDA # then STA zp
+ * or abs, LDA zp then STA zp, LDA abs then STA abs, LDX # or zp then STX zp) make
+ * common. The pair is recognized in the case of its first instruction, so it costs one
+ * dispatch, and the deadline is checked once for both: the pair only runs fused if the
+ * deadline is past the end of the first instruction, in which case the loop would have
+ * started the second anyway. Cycles, flags and memory accesses are the same as for the two
+ * instructions on their own.
+ */
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+template <bool Fused>
+constexpr u32 BasicCpu<Variant, Hooks, Timing, Bus>::dispatch(const OP opCode, Bus& memory)
+{
+    if constexpr (!Timing::c_cycleExact)
+    {
+        // The opcode fetch wasn't counted, the instruction is charged as a whole
+        m_cycles += detail::c_opCodeCycles<Variant>[opCode];
+    }
+    if (detail::tracing() && isValidOpCode(opCode))
+    {
+        detail::traceInstruction(OpCodeToString(opCode));
+    }
+
+    switch (static_cast<u8>(opCode))
+    {
+        case OP::LDA_IM:
+        {
+            if (Fused && fusesWith(OP::LDX_IM, 1, 1, memory))
+            {
+                load<&CpuState::A, AddrMode::Immediate>(memory);
+                fetchFusedOpCode(OP::LDX_IM, memory);
+                load<&CpuState::X, AddrMode::Immediate>(memory);
+                return 2;
+            }
+            if (Fused && fusesWith(OP::STA_ZP, 1, 1, memory))
+            {
+                load<&CpuState::A, AddrMode::Immediate>(memory);
+                fetchFusedOpCode(OP::STA_ZP, memory);
+                store<&CpuState::A, AddrMode::ZeroPage>(memory);
+                return 2;
+            }
+            if (Fused && fusesWith(OP::STA_ABS, 1, 1, memory))
+            {
+                load<&CpuState::A, AddrMode::Immediate>(memory);
+                fetchFusedOpCode(OP::STA_ABS, memory);
+                store<&CpuState::A, AddrMode::Absolute>(memory);
+                return 2;
+            }
+            load<&CpuState::A, AddrMode::Immediate>(memory);
+            break;
+        }
+        case OP::LDA_ZP:
+        {
+            if (Fused && fusesWith(OP::LDX_ZP, 1, 2, memory))
+            {
+                load<&CpuState::A, AddrMode::ZeroPage>(memory);
+                fetchFusedOpCode(OP::LDX_ZP, memory);
+                load<&CpuState::X, AddrMode::ZeroPage>(memory);
+                return 2;
+            }
+            if (Fused && fusesWith(OP::STA_ZP, 1, 2, memory))
+            {
+                load<&CpuState::A, AddrMode::ZeroPage>(memory);
+                fetchFusedOpCode(OP::STA_ZP, memory);
+                store<&CpuState::A, AddrMode::ZeroPage>(memory);
+                return 2;
+            }
+            load<&CpuState::A, AddrMode::ZeroPage>(memory);
+            break;
+        }
+        case OP::LDA_ZPX:
+        {
+            load<&CpuState::A, AddrMode::ZeroPageX>(memory);
+            break;
+        }
+        case OP::LDA_ABS:
+        {
+            if (Fused && fusesWith(OP::LDX_ABS, 2, 3, memory))
+            {
+                load<&CpuState::A, AddrMode::Absolute>(memory);
+                fetchFusedOpCode(OP::LDX_ABS, memory);
+                load<&CpuState::X, AddrMode::Absolute>(memory);
+                return 2;
+            }
+            if (Fused && fusesWith(OP::STA_ABS, 2, 3, memory))
+            {
+                load<&CpuState::A, AddrMode::Absolute>(memory);
+                fetchFusedOpCode(OP::STA_ABS, memory);
+                store<&CpuState::A, AddrMode::Absolute>(memory);
+                return 2;
+            }
+            load<&CpuState::A, AddrMode::Absolute>(memory);
+            break;
+        }
+        case OP::LDA_ABSX:
+        {
+            load<&CpuState::A, AddrMode::AbsoluteX>(memory);
+            break;
+        }
+        case OP::LDA_ABSY:
+        {
+            load<&CpuState::A, AddrMode::AbsoluteY>(memory);
+            break;
+        }
+        case OP::LDA_IND_ZPX:
+        {
+            load<&CpuState::A, AddrMode::ZeroPageIndirectX>(memory);
+            break;
+        }
+        case OP::LDA_IND_ZPY:
+        {
+            load<&CpuState::A, AddrMode::ZeroPageIndirectY>(memory);
+            break;
+        }
+        case OP::LDX_IM:
+        {
+            if (Fused && fusesWith(OP::TXS, 1, 1, memory))
+            {
+                load<&CpuState::X, AddrMode::Immediate>(memory);
+                fetchFusedOpCode(OP::TXS, memory);
+                transferXToStackPointer(memory);
+                return 2;
+            }
+            if (Fused && fusesWith(OP::STX_ZP, 1, 1, memory))
+            {
+                load<&CpuState::X, AddrMode::Immediate>(memory);
+                fetchFusedOpCode(OP::STX_ZP, memory);
+                store<&CpuState::X, AddrMode::ZeroPage>(memory);
+                return 2;
+            }
+            load<&CpuState::X, AddrMode::Immediate>(memory);
+            break;
+        }
+        case OP::LDX_ZP:
+        {
+            if (Fused && fusesWith(OP::STX_ZP, 1, 2, memory))
+            {
+                load<&CpuState::X, AddrMode::ZeroPage>(memory);
+                fetchFusedOpCode(OP::STX_ZP, memory);
+                store<&CpuState::X, AddrMode::ZeroPage>(memory);
+                return 2;
+            }
+            load<&CpuState::X, AddrMode::ZeroPage>(memory);
+            break;
+        }
+        case OP::LDX_ZPY:
+        {
+            load<&CpuState::X, AddrMode::ZeroPageY>(memory);
+            break;
+        }
+        case OP::LDX_ABS:
+        {
+            load<&CpuState::X, AddrMode::Absolute>(memory);
+            break;
+        }
+        case OP::LDX_ABSY:
+        {
+            load<&CpuState::X, AddrMode::AbsoluteY>(memory);
+            break;
+        }
+        case OP::LDY_IM:
+        {
+            load<&CpuState::Y, AddrMode::Immediate>(memory);
+            break;
+        }
+        case OP::LDY_ZP:
+        {
+            load<&CpuState::Y, AddrMode::ZeroPage>(memory);
+            break;
+        }
+        case OP::LDY_ZPX:
+        {
+            load<&CpuState::Y, AddrMode::ZeroPageX>(memory);
+            break;
+        }
+        case OP::LDY_ABS:
+        {
+            load<&CpuState::Y, AddrMode::Absolute>(memory);
+            break;
+        }
+        case OP::LDY_ABSX:
+        {
+            load<&CpuState::Y, AddrMode::AbsoluteX>(memory);
+            break;
+        }
+        case OP::STA_ZP:
+        {
+            store<&CpuState::A, AddrMode::ZeroPage>(memory);
+            break;
+        }
+        case OP::STA_ZPX:
+        {
+            store<&CpuState::A, AddrMode::ZeroPageX>(memory);
+            break;
+        }
+        case OP::STA_ABS:
+        {
+            store<&CpuState::A, AddrMode::Absolute>(memory);
+            break;
+        }
+        case OP::STA_ABSX:
+        {
+            store<&CpuState::A, AddrMode::AbsoluteX>(memory);
+            break;
+        }
+        case OP::STA_ABSY:
+        {
+            store<&CpuState::A, AddrMode::AbsoluteY>(memory);
+            break;
+        }
+        case OP::STA_IND_ZPX:
+        {
+            store<&CpuState::A, AddrMode::ZeroPageIndirectX>(memory);
+            break;
+        }
+        case OP::STA_IND_ZPY:
+        {
+            store<&CpuState::A, AddrMode::ZeroPageIndirectY>(memory);
+            break;
+        }
+        case OP::STX_ZP:
+        {
+            store<&CpuState::X, AddrMode::ZeroPage>(memory);
+            break;
+        }
+        case OP::STX_ZPY:
+        {
+            store<&CpuState::X, AddrMode::ZeroPageY>(memory);
+            break;
+        }
+        case OP::STX_ABS:
+        {
+            store<&CpuState::X, AddrMode::Absolute>(memory);
+            break;
+        }
+        case OP::STY_ZP:
+        {
+            store<&CpuState::Y, AddrMode::ZeroPage>(memory);
+            break;
+        }
+        case OP::STY_ZPX:
+        {
+            store<&CpuState::Y, AddrMode::ZeroPageX>(memory);
+            break;
+        }
+        case OP::STY_ABS:
+        {
+            store<&CpuState::Y, AddrMode::Absolute>(memory);
+            break;
+        }
+        case OP::TXS:
+        {
+            transferXToStackPointer(memory);
+            break;
+        }
+        case OP::NOP:
+        {
+            if (Fused && fusesWith(OP::NOP, 0, 1, memory))
+            {
+                nop<AddrMode::Implied>(memory);
+                fetchFusedOpCode(OP::NOP, memory);
+                nop<AddrMode::Implied>(memory);
+                return 2;
+            }
+            nop<AddrMode::Implied>(memory);
+            break;
+        }
+        // 65C02
+        case OP::LDA_IND_ZP:
+        {
+            if constexpr (Variant::c_cmosOpCodes)
+            {
+                load<&CpuState::A, AddrMode::ZeroPageIndirect>(memory);
+                break;
+            }
+            return 0;
+        }
+        case OP::STA_IND_ZP:
+        {
+            if constexpr (Variant::c_cmosOpCodes)
+            {
+                store<&CpuState::A, AddrMode::ZeroPageIndirect>(memory);
+                break;
+            }
+            return 0;
+        }
+        // Undocumented
+        case OP::LAX_ZP:
+        {
+            if constexpr (Variant::c_undocumentedOpCodes)
+            {
+                loadAX<AddrMode::ZeroPage>(memory);
+                break;
+            }
+            return 0;
+        }
+        case OP::LAX_ZPY:
+        {
+            if constexpr (Variant::c_undocumentedOpCodes)
+            {
+                loadAX<AddrMode::ZeroPageY>(memory);
+                break;
+            }
+            return 0;
+        }
+        case OP::LAX_ABS:
+        {
+            if constexpr (Variant::c_undocumentedOpCodes)
+            {
+                loadAX<AddrMode::Absolute>(memory);
+                break;
+            }
+            return 0;
+        }
+        case OP::LAX_ABSY:
+        {
+            if constexpr (Variant::c_undocumentedOpCodes)
+            {
+                loadAX<AddrMode::AbsoluteY>(memory);
+                break;
+            }
+            return 0;
+        }
+        case OP::LAX_IND_ZPX:
+        {
+            if constexpr (Variant::c_undocumentedOpCodes)
+            {
+                loadAX<AddrMode::ZeroPageIndirectX>(memory);
+                break;
+            }
+            return 0;
+        }
+        case OP::LAX_IND_ZPY:
+        {
+            if constexpr (Variant::c_undocumentedOpCodes)
+            {
+                loadAX<AddrMode::ZeroPageIndirectY>(memory);
+                break;
+            }
+            return 0;
+        }
+        case 0x1A:
+        case 0x3A:
+        case 0x5A:
+        case 0x7A:
+        case 0xDA:
+        case 0xFA:
+        {
+            if constexpr (Variant::c_undocumentedOpCodes)
+            {
+                nop<AddrMode::Implied>(memory);
+                break;
+            }
+            return 0;
+        }
+        case 0x80:
+        case 0x82:
+        case 0x89:
+        case 0xC2:
+        case 0xE2:
+        {
+            if constexpr (Variant::c_undocumentedOpCodes)
+            {
+                nop<AddrMode::Immediate>(memory);
+                break;
+            }
+            return 0;
+        }
+        case 0x04:
+        case 0x44:
+        case 0x64:
+        {
+            if constexpr (Variant::c_undocumentedOpCodes)
+            {
+                nop<AddrMode::ZeroPage>(memory);
+                break;
+            }
+            return 0;
+        }
+        case 0x14:
+        case 0x34:
+        case 0x54:
+        case 0x74:
+        case 0xD4:
+        case 0xF4:
+        {
+            if constexpr (Variant::c_undocumentedOpCodes)
+            {
+                nop<AddrMode::ZeroPageX>(memory);
+                break;
+            }
+            return 0;
+        }
+        case 0x0C:
+        {
+            if constexpr (Variant::c_undocumentedOpCodes)
+            {
+                nop<AddrMode::Absolute>(memory);
+                break;
+            }
+            return 0;
+        }
+        case 0x1C:
+        case 0x3C:
+        case 0x5C:
+        case 0x7C:
+        case 0xDC:
+        case 0xFC:
+        {
+            if constexpr (Variant::c_undocumentedOpCodes)
+            {
+                nop<AddrMode::AbsoluteX>(memory);
+                break;
+            }
+            return 0;
+        }
+        default:
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+template <u8 CpuState::*reg, AddrMode mode>
+constexpr void BasicCpu<Variant, Hooks, Timing, Bus>::load(Bus& memory)
+{
+    const u8 value = readOperand<mode>(memory);
+    loadIntoRegister(this->*reg, value);
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+template <AddrMode mode>
+constexpr void BasicCpu<Variant, Hooks, Timing, Bus>::loadAX(Bus& memory)
+{
+    const u8 value = readOperand<mode>(memory);
+    loadIntoRegister(A, value);
+    X = value;
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+template <u8 CpuState::*reg, AddrMode mode>
+constexpr void BasicCpu<Variant, Hooks, Timing, Bus>::store(Bus& memory)
+{
+    const u16 address = writeAddress<mode>(memory);
+    writeByte(address, this->*reg, memory);
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+template <AddrMode mode>
+constexpr void BasicCpu<Variant, Hooks, Timing, Bus>::nop(Bus& memory)
+{
+    if constexpr (mode == AddrMode::Implied)
+    {
+        dummyRead(PC, memory);
+    }
+    else
+    {
+        // The operand is read and thrown away, taking the same cycles as a load
+        readOperand<mode>(memory);
+    }
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr void BasicCpu<Variant, Hooks, Timing, Bus>::transferXToStackPointer(Bus& memory)
+{
+    dummyRead(PC, memory);
+    SP = X;
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+template <typename Coverage, bool Fused>
+constexpr StopStatus BasicCpu<Variant, Hooks, Timing, Bus>::executeLoop(Bus& memory,
+                                                                        Coverage& coverage) noexcept
+{
+    const u64 start = m_cycles;
+    u64 instructions = 0;
+
+    while (m_cycles < m_deadline)
+    {
+        coverage.visit(PC);
+
+        // Fetch instruction from memory
+        const u16 insAddr = PC;
+        const u8 byte = fetchByte(memory);
+        const auto ins = static_cast<OP>(byte);
+
+        this->preInstruction(*this, insAddr, byte);
+        const u32 executed = dispatch<Fused>(ins, memory);
+        if (executed == 0)
+        {
+            return {StopReason::InvalidOpCode, byte, insAddr, m_cycles - start, instructions};
+        }
+        this->postInstruction(*this, insAddr, byte);
+        instructions += executed;
+
+        if (this->stopRequested())
+        {
+            return {StopReason::HookRequested, 0, PC, m_cycles - start, instructions};
+        }
+    }
+
+    return {StopReason::CyclesExhausted, 0, PC, m_cycles - start, instructions};
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr s32 BasicCpu<Variant, Hooks, Timing, Bus>::execute(s32 cycles, Bus& memory)
+{
+    detail::NoCoverage coverage;
+    m_deadline = deadlineIn(cycles);
+    return detail::throwOnInvalidOpCode(executeLoop(memory, coverage));
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr s32 BasicCpu<Variant, Hooks, Timing, Bus>::execute(s32 cycles,
+                                                             Bus& memory,
+                                                             EdgeCoverage& coverage)
+{
+    m_deadline = deadlineIn(cycles);
+    return detail::throwOnInvalidOpCode(executeLoop(memory, coverage));
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr StopStatus BasicCpu<Variant, Hooks, Timing, Bus>::run(s32 cycles, Bus& memory) noexcept
+{
+    detail::NoCoverage coverage;
+    m_deadline = deadlineIn(cycles);
+    return executeLoop(memory, coverage);
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr StopStatus BasicCpu<Variant, Hooks, Timing, Bus>::run(s32 cycles,
+                                                                Bus& memory,
+                                                                EdgeCoverage& coverage) noexcept
+{
+    m_deadline = deadlineIn(cycles);
+    return executeLoop(memory, coverage);
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr StopStatus BasicCpu<Variant, Hooks, Timing, Bus>::runFused(s32 cycles,
+                                                                     Bus& memory) noexcept
+{
+    static_assert(std::is_same_v<Hooks, NoHooks>,
+                  "The hooks would miss the second instruction of every superinstruction");
+
+    detail::NoCoverage coverage;
+    m_deadline = deadlineIn(cycles);
+    return executeLoop<detail::NoCoverage, true>(memory, coverage);
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+constexpr StopStatus BasicCpu<Variant, Hooks, Timing, Bus>::runUntil(const u64 deadline,
+                                                                     Bus& memory) noexcept
+{
+    detail::NoCoverage coverage;
+    m_deadline = deadline;
+    return executeLoop(memory, coverage);
+}
+
+template <typename Variant, typename Hooks, typename Timing, typename Bus>
+void BasicCpu<Variant, Hooks, Timing, Bus>::executeInfinite(Bus& memory)
+{
+    while (true)
+    {
+        // Fetch instruction from memory
+        const u16 insAddr = PC;
+        const u8 byte = fetchByte(memory);
+        const auto ins = static_cast<OP>(byte);
+
+        this->preInstruction(*this, insAddr, byte);
+        executeInstruction(ins, memory);
+        this->postInstruction(*this, insAddr, byte);
+    }
+}
+
+namespace detail
+{
+template <typename Variant>
+constexpr std::array<u8, 256> measureOpCodeCycles()
+{
+    // Zeroed memory and index registers, so no instruction crosses a page
+    Memory memory{};
+    std::array<u8, 256> cycles{};
+    for (unsigned opCode = 0; opCode < cycles.size(); ++opCode)
+    {
+        BasicCpu<Variant, NoHooks, CycleExact> cpu{};
+        cpu.resetRegisters(0x0200);
+        memory[0x0200] = static_cast<u8>(opCode);
+
+        cpu.fetchByte(memory);
+        cpu.tryExecuteInstruction(static_cast<CpuState::OP>(opCode), memory);
+        cycles[opCode] = static_cast<u8>(cpu.cycles());
+    }
+    return cycles;
+}
+} // namespace detail
+
+} // namespace c6502
+
+#include "c6502/c6502AddrModesImpl.h"
@@ -0,0 +1,238 @@
+#pragma once
+
+#include "c6502/c6502.h"
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <memory>
+
+namespace c6502
+{
+class BankedMemory;
+
+/* A ROM image in a sealed memfd or in a read only file, mapped by BankedMemory instead of
+ * copied into it. Every machine in every process that maps the same image shares its
+ * physical pages, only the RAM is private. The descriptor can be passed to other processes
+ * by fork() or over a Unix socket and taken over there with fromDescriptor.
+ */
+class RomImage
+{
+public:
+    /// Copies the bytes into a new memfd, once, and seals it against any change
+    RomImage(const u8* data, std::size_t size);
+
+    /// Opens a ROM file, the page cache shares it between processes
+    static RomImage open(const char* path);
+
+    /// Takes over the descriptor of an image another process created or opened
+    static RomImage fromDescriptor(int fd);
+
+    RomImage(RomImage&& other) noexcept;
+    RomImage& operator=(RomImage&& other) noexcept;
+    ~RomImage();
+
+    RomImage(const RomImage&) = delete;
+    RomImage& operator=(const RomImage&) = delete;
+
+    int descriptor() const
+    {
+        return m_fd;
+    }
+
+    std::size_t size() const
+    {
+        return m_size;
+    }
+
+private:
+    RomImage(int fd, std::size_t size);
+
+    int m_fd = -1;
+    std::size_t m_size = 0;
+};
+
+/// Decides which part of a BankedMemory's image each page shows and how its registers work
+class Mapper
+{
+public:
+    virtual ~Mapper() = default;
+
+    /// Maps the power on banks and registers the pages of the mapper's registers
+    virtual void reset(BankedMemory& memory) = 0;
+
+    /// Called for every write to a register page, after the write itself
+    virtual void writeRegister(BankedMemory& memory, u16 address, u8 value) = 0;
+};
+
+/* A 64 KB address space of 256 byte pages over a ROM and RAM image of any size.
+ *
+ * The image is one mmap'ed buffer: the ROM, then the RAM, then a page of zeros that
+ * unmapped pages read and a page that writes to ROM and to unmapped pages are dropped
+ * into. The address space is 8 slots of 8 KB, each with a read and a write table of one
+ * pointer per page into the buffer, so an access is two table lookups. The tables of every
+ * 8 KB of the ROM are built once, so mapping a slot aligned bank of the ROM points the slot
+ * at its tables, a 16 KB switch writes 2 pairs of slot pointers and a 32 KB switch 4,
+ * without copying. RAM, unmapped pages and ROM banks that are not slot aligned are mapped
+ * page by page in tables of the slot's own. Banks past the end of the ROM or RAM wrap
+ * around, the way unconnected address lines mirror them on a cartridge.
+ *
+ * The ROM is either private to the memory or a RomImage mapped read only and shared with
+ * every other memory that maps it.
+ *
+ * It's a Bus for BasicCpu, see BankedCpu.
+ */
+class BankedMemory
+{
+public:
+    static constexpr std::size_t c_pageSize = 0x100;
+    static constexpr std::size_t c_pageCount = Memory::MEM_MAX / c_pageSize;
+    static constexpr std::size_t c_slotSize = 8 * 1024;
+    static constexpr std::size_t c_slotPages = c_slotSize / c_pageSize;
+    static constexpr std::size_t c_slotCount = Memory::MEM_MAX / c_slotSize;
+
+    /// Allocates the image and resets the mapper, the sizes are rounded up to whole pages
+    BankedMemory(std::size_t romSize, std::size_t ramSize, std::unique_ptr<Mapper> mapper);
+
+    /// Maps a shared ROM instead of allocating one, the RAM is private
+    BankedMemory(const RomImage& rom, std::size_t ramSize, std::unique_ptr<Mapper> mapper);
+    ~BankedMemory();
+
+    BankedMemory(const BankedMemory&) = delete;
+    BankedMemory& operator=(const BankedMemory&) = delete;
+
+    u8 operator[](const u16 address) const
+    {
+        return (*m_readSlots[address >> 13])[(address >> 8) & (c_slotPages - 1)][address & 0xFF];
+    }
+
+    void write(const u16 address, const u8 value)
+    {
+        const u8 page = address >> 8;
+        (*m_writeSlots[address >> 13])[page & (c_slotPages - 1)][address & 0xFF] = value;
+        if (m_registerPages.test(page))
+        {
+            m_mapper->writeRegister(*this, address, value);
+        }
+    }
+
+    /// The ROM, read only when it's shared
+    u8* rom()
+    {
+        return m_buffer;
+    }
+
+    bool isRomShared() const
+    {
+        return m_romShared;
+    }
+
+    std::size_t romSize() const
+    {
+        return m_romSize;
+    }
+
+    u8* ram()
+    {
+        return m_buffer + m_ramOffset;
+    }
+
+    std::size_t ramSize() const
+    {
+        return m_ramSize;
+    }
+
+    Mapper& mapper()
+    {
+        return *m_mapper;
+    }
+
+    /// Maps the ROM from offset to count pages from firstPage, writes to them are dropped
+    void mapRom(u8 firstPage, std::size_t count, std::size_t offset);
+
+    /// Maps the RAM from offset to count pages from firstPage
+    void mapRam(u8 firstPage, std::size_t count, std::size_t offset);
+
+    /// Leaves count pages from firstPage unconnected, they read zeros
+    void unmap(u8 firstPage, std::size_t count);
+
+    /// Hands writes to count pages from firstPage to the mapper
+    void registerPages(u8 firstPage, std::size_t count);
+
+    /// Unmaps everything and maps the mapper's power on banks, the image is left as it is
+    void reset();
+
+private:
+    using ReadTable = std::array<const u8*, c_slotPages>;
+    using WriteTable = std::array<u8*, c_slotPages>;
+
+    /// Maps the buffer, with the ROM from the image when there is one, and builds the tables
+    void allocate(const RomImage* rom);
+
+    /// Points one page at read and write, in the slot's own tables
+    void mapPage(std::size_t page, const u8* read, u8* write);
+
+    u8* zeroPage() const
+    {
+        return m_buffer + m_ramOffset + m_ramSize;
+    }
+
+    u8* discardPage() const
+    {
+        return zeroPage() + c_pageSize;
+    }
+
+    u8* m_buffer = nullptr;
+    std::size_t m_bufferSize = 0;
+    std::size_t m_romSize = 0;
+    std::size_t m_ramOffset = 0; // The ROM fills whole host pages so it can be mapped alone
+    std::size_t m_ramSize = 0;
+    bool m_romShared = false;
+
+    std::array<const ReadTable*, c_slotCount> m_readSlots{};
+    std::array<const WriteTable*, c_slotCount> m_writeSlots{};
+    std::array<ReadTable, c_slotCount> m_ownReads{};
+    std::array<WriteTable, c_slotCount> m_ownWrites{};
+    std::unique_ptr<ReadTable[]> m_romReads; // One table per 8 KB of the ROM, rounded up
+    ReadTable m_zeroReads{};
+    WriteTable m_discardWrites{};
+    std::bitset<c_pageCount> m_registerPages;
+    std::unique_ptr<Mapper> m_mapper;
+};
+
+using BankedCpu = BasicCpu<Nmos6502, NoHooks, CycleExact, BankedMemory>;
+
+/* Example mappers. All of them mirror the RAM over $0000-$7FFF and put the ROM in
+ * $8000-$FFFF, the NES cartridge boards they are named after work the same way.
+ */
+
+/// No bank switching, 16 KB of ROM is mirrored in both halves and 32 KB fills them
+class NromMapper : public Mapper
+{
+public:
+    void reset(BankedMemory& memory) override;
+    void writeRegister(BankedMemory& memory, u16 address, u8 value) override;
+};
+
+/// 16 KB banks, the bank at $8000 is selected by a write to $8000-$FFFF and the last bank
+/// is fixed at $C000
+class UxromMapper : public Mapper
+{
+public:
+    static constexpr std::size_t c_bankSize = 16 * 1024;
+
+    void reset(BankedMemory& memory) override;
+    void writeRegister(BankedMemory& memory, u16 address, u8 value) override;
+};
+
+/// 32 KB banks, the bank at $8000 is selected by a write to $8000-$FFFF
+class AxromMapper : public Mapper
+{
+public:
+    static constexpr std::size_t c_bankSize = 32 * 1024;
+
+    void reset(BankedMemory& memory) override;
+    void writeRegister(BankedMemory& memory, u16 address, u8 value) override;
+};
+
+} // namespace c6502
@@ -0,0 +1,293 @@
+#pragma once
+
+#include "c6502/c6502.h"
+#include "c6502/c6502Stats.h"
+
+#include <bitset>
+#include <coroutine>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace c6502
+{
+/* Peripherals written as coroutines.
+ *
+ * A device is a coroutine returning Device that co_awaits either a number of CPU cycles
+ * or an access to a range of addresses:
+ *
+ *     Device timer(Scheduler& scheduler)
+ *     {
+ *         while (true)
+ *         {
+ *             co_await scheduler.cycles(256);
+ *             scheduler.memory()[0xD000]++;
+ *         }
+ *     }
+ *
+ * The Scheduler runs the CPU up to the next cycle a device waits for and resumes the
+ * devices in cycle order, timers and bus accesses alike. While a device runs,
+ * scheduler.now() is the cycle it was due at, or the cycle the access it waited for was
+ * made in. CPU time advances a whole instruction at a time though, so the devices due
+ * within an instruction are resumed after it: what a device writes is seen by the next
+ * instruction, not by the rest of the one it was due in.
+ */
+
+class Scheduler;
+
+/// Owns a device coroutine, which starts suspended until it is added to a Scheduler
+class Device
+{
+public:
+    struct promise_type
+    {
+        Device get_return_object()
+        {
+            return Device(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_always final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void()
+        {
+        }
+
+        /// Exceptions escape from the resume, out of Scheduler::run
+        void unhandled_exception()
+        {
+            throw;
+        }
+    };
+
+    Device(Device&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr))
+    {
+    }
+
+    Device& operator=(Device&& other) noexcept
+    {
+        std::swap(m_handle, other.m_handle);
+        return *this;
+    }
+
+    ~Device()
+    {
+        if (m_handle)
+        {
+            m_handle.destroy();
+        }
+    }
+
+    std::coroutine_handle<> handle() const
+    {
+        return m_handle;
+    }
+
+private:
+    explicit Device(const std::coroutine_handle<promise_type> handle) : m_handle(handle)
+    {
+    }
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+/// A memory access made by the CPU
+struct BusAccess
+{
+    u16 address;
+    u8 value;
+    bool write;
+    u64 cycle; // CPU cycles executed once the access is made
+};
+
+/// Tells the scheduler which accesses the CPU makes, and stops it after an instruction
+/// that made one a device waits for
+struct PeripheralHooks : public NoHooks
+{
+    void onRead(u16 address, u8 value);
+    void onWrite(u16 address, u8 value);
+
+    bool stopRequested() const
+    {
+        return !accesses.empty();
+    }
+
+    std::bitset<256> watchedPages;
+    std::vector<BusAccess> accesses;
+};
+
+using PeripheralCpu = BasicCpu<Nmos6502, PeripheralHooks>;
+
+/* The hooks are the base of PeripheralCpu, the clock is read from there. It counts the bus
+ * cycles before the one the access is made in. */
+inline void PeripheralHooks::onRead(const u16 address, const u8 value)
+{
+    if (watchedPages.test(address >> 8))
+    {
+        const u64 cycle = static_cast<const PeripheralCpu&>(*this).cycles() + 1;
+        accesses.push_back({address, value, false, cycle});
+    }
+}
+
+inline void PeripheralHooks::onWrite(const u16 address, const u8 value)
+{
+    if (watchedPages.test(address >> 8))
+    {
+        const u64 cycle = static_cast<const PeripheralCpu&>(*this).cycles() + 1;
+        accesses.push_back({address, value, true, cycle});
+    }
+}
+
+/// Runs a CPU and the devices around it in cycle order
+class Scheduler
+{
+public:
+    explicit Scheduler(Memory& memory) : m_memory(memory)
+    {
+    }
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    PeripheralCpu& cpu()
+    {
+        return m_cpu;
+    }
+
+    Memory& memory()
+    {
+        return m_memory;
+    }
+
+    /// Counters of the CPU, safe to read while the scheduler runs
+    const Stats& stats() const
+    {
+        return m_stats;
+    }
+
+    /// Cycles executed since the scheduler was created, or the cycle the device being
+    /// resumed was due at
+    u64 now() const
+    {
+        return m_resuming ? m_resumeTime : m_cpu.cycles();
+    }
+
+    /// Starts a device, it runs up to its first co_await right away
+    void add(Device device);
+
+    /// Runs the CPU and the devices for at least the given cycles, stops early on an
+    /// invalid opcode. The cycles and instructions are those of the whole run.
+    StopStatus run(u64 cycles);
+
+    struct CyclesAwaiter
+    {
+        bool await_ready() const noexcept
+        {
+            return cycles == 0;
+        }
+
+        void await_suspend(const std::coroutine_handle<> handle)
+        {
+            scheduler.wakeAt(scheduler.now() + cycles, handle);
+        }
+
+        void await_resume() const noexcept
+        {
+        }
+
+        Scheduler& scheduler;
+        u64 cycles;
+    };
+
+    struct AccessAwaiter
+    {
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        void await_suspend(const std::coroutine_handle<> handle)
+        {
+            scheduler.wakeOnAccess(first, last, handle, access);
+        }
+
+        BusAccess await_resume() const noexcept
+        {
+            return access;
+        }
+
+        Scheduler& scheduler;
+        u16 first;
+        u16 last;
+        BusAccess access{};
+    };
+
+    /// co_await to resume once the CPU has executed the given cycles
+    CyclesAwaiter cycles(const u64 count)
+    {
+        return {*this, count};
+    }
+
+    /// co_await to resume after the CPU has accessed an address in [first, last]
+    AccessAwaiter access(const u16 first, const u16 last)
+    {
+        return {*this, first, last};
+    }
+
+    AccessAwaiter access(const u16 address)
+    {
+        return access(address, address);
+    }
+
+private:
+    struct Timer
+    {
+        u64 time;
+        u64 sequence; // Devices due in the same cycle are resumed in the order they waited
+        std::coroutine_handle<> handle;
+
+        bool operator>(const Timer& other) const
+        {
+            return time != other.time ? time > other.time : sequence > other.sequence;
+        }
+    };
+
+    struct Watch
+    {
+        u16 first;
+        u16 last;
+        std::coroutine_handle<> handle;
+        BusAccess* access;
+    };
+
+    void wakeAt(u64 time, std::coroutine_handle<> handle);
+    void wakeOnAccess(u16 first, u16 last, std::coroutine_handle<> handle, BusAccess& access);
+
+    void resumeAt(u64 time, std::coroutine_handle<> handle);
+    void resumeTimersUntil(u64 time);
+    void deliverAccesses();
+    void updateWatchedPages();
+
+    PeripheralCpu m_cpu;
+    Memory& m_memory;
+    Stats m_stats;
+    u64 m_sequence = 0;
+    bool m_resuming = false;
+    u64 m_resumeTime = 0;
+
+    std::vector<Device> m_devices;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> m_timers;
+    std::vector<Watch> m_watches;
+    std::vector<Watch> m_delivering;
+    std::vector<BusAccess> m_accesses;
+};
+
+} // namespace c6502
@@ -0,0 +1,200 @@
+#pragma once
+
+#include "c6502/c6502.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace c6502
+{
+/// A 128 bit hash, wide enough that two different states never share one by accident. It's
+/// not a cryptographic hash, a cache fed by an adversary could be poisoned.
+struct Hash128
+{
+    u64 low = 0;
+    u64 high = 0;
+
+    /// Hashes the words, a different seed gives an unrelated hash
+    static Hash128 of(const u64* words, std::size_t count, u64 seed);
+};
+
+inline bool operator==(const Hash128& lhs, const Hash128& rhs)
+{
+    return lhs.low == rhs.low && lhs.high == rhs.high;
+}
+
+/* The hash of a Memory, kept as one hash per 256 byte page.
+ *
+ * Hashing all 64 KB takes microseconds, combining the page hashes takes a fraction of that.
+ * A MemoryHash kept next to its memory and updated for the pages that change, which a
+ * RunCache does for the runs it makes, turns the hash of every next state into a combine.
+ */
+class MemoryHash
+{
+public:
+    static constexpr std::size_t c_pageSize = 0x100;
+    static constexpr std::size_t c_pageCount = Memory::MEM_MAX / c_pageSize;
+
+    /// Hashes every page
+    explicit MemoryHash(const Memory& memory);
+
+    /// Rehashes a page after it was written
+    void update(const Memory& memory, u8 page);
+
+    const Hash128& page(const u8 page) const
+    {
+        return m_pages[page];
+    }
+
+    /// The hash of the whole memory
+    Hash128 combined() const;
+
+private:
+    std::array<Hash128, c_pageCount> m_pages;
+};
+
+/// Counters of a RunCache
+struct RunCacheStats
+{
+    u64 hits = 0;      // Runs answered from memory
+    u64 diskHits = 0;  // Runs answered from the directory
+    u64 misses = 0;    // Runs executed
+    u64 evictions = 0; // Results dropped from memory to stay within the capacity
+    u64 bytes = 0;     // Memory held by the results
+};
+
+/* Remembers the outcome of runs by the state they started from, so that a run from a state
+ * seen before puts the CPU and memory in its final state without executing.
+ *
+ * A run is keyed by the hash of the registers, the memory, the budget and the CPU variant.
+ * The cycle counter isn't part of it, a run goes as far past its start whatever the clock
+ * says, and neither is the timing policy, the fast and cycle exact timings finish in the
+ * same state. A result is the stop status, the registers and the pages the run changed.
+ *
+ * The most recently used results are kept in memory up to a capacity in bytes. With a
+ * directory every result is written there as well, one file per key, and read back when
+ * it isn't in memory, so results survive the process and are shared by every process
+ * using the directory. The files are in the byte order of the host.
+ *
+ * Opt in: only CPUs without hooks can use it, the hooks of a cached run would never be
+ * called. Any thread can use it.
+ */
+class RunCache
+{
+public:
+    /// Keeps results in memory up to capacityBytes, and in directory when it isn't empty
+    explicit RunCache(std::size_t capacityBytes, std::filesystem::path directory = {});
+
+    /// Runs the CPU like cpu.run, from the cache when the run was made before
+    template <typename Cpu>
+    StopStatus run(Cpu& cpu, s32 cycles, Memory& memory);
+
+    /// Like run, with the hash of memory kept up to date across runs instead of rehashed.
+    /// The hash must be the hash of memory as it is, it's the hash of the final memory after.
+    template <typename Cpu>
+    StopStatus run(Cpu& cpu, s32 cycles, Memory& memory, MemoryHash& hash);
+
+    RunCacheStats stats() const;
+
+private:
+    struct Result
+    {
+        StopStatus status;
+        CpuState registers;
+        std::vector<u8> pageIndices; // The pages the run changed
+        std::vector<u8> pages;       // Their contents after the run, one page after another
+
+        std::size_t bytes() const
+        {
+            return sizeof(Result) + pageIndices.capacity() + pages.capacity();
+        }
+    };
+
+    using Entry = std::pair<Hash128, std::shared_ptr<const Result>>;
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Hash128& key) const
+        {
+            return static_cast<std::size_t>(key.low);
+        }
+    };
+
+    /// The bits of the variant traits that change what a run does
+    template <typename Variant>
+    static constexpr u64 variantBits()
+    {
+        return (Variant::c_decimalMode ? 1 : 0) | (Variant::c_jmpIndirectPageWrap ? 2 : 0) |
+               (Variant::c_undocumentedOpCodes ? 4 : 0) | (Variant::c_cmosOpCodes ? 8 : 0);
+    }
+
+    static Hash128 key(const CpuState& cpu, u64 variant, s32 cycles, const MemoryHash& hash);
+
+    /// Looks the key up in memory, then in the directory
+    std::shared_ptr<const Result> find(const Hash128& key);
+
+    /// Puts the final state of a result in the CPU registers and memory
+    static void apply(const Result& result, CpuState& cpu, Memory& memory, MemoryHash& hash);
+
+    /// Records a run from the initial memory and stores it under the key
+    void record(const Hash128& key,
+                const StopStatus& status,
+                const CpuState& cpu,
+                const std::vector<u8>& initial,
+                const Memory& memory,
+                MemoryHash& hash);
+
+    /// Makes the result the most recently used one and evicts down to the capacity
+    void insert(const Hash128& key, std::shared_ptr<const Result> result);
+
+    std::filesystem::path path(const Hash128& key) const;
+    std::shared_ptr<const Result> load(const Hash128& key) const;
+    void store(const Hash128& key, const Result& result);
+
+    const std::size_t m_capacityBytes;
+    const std::filesystem::path m_directory;
+
+    mutable std::mutex m_mutex; // Guards the results and the counters
+    std::list<Entry> m_results; // Most recently used first
+    std::unordered_map<Hash128, std::list<Entry>::iterator, KeyHash> m_index;
+    RunCacheStats m_stats;
+
+    std::atomic<u64> m_temporaryFiles{0}; // Names the files being written
+};
+
+template <typename Cpu>
+StopStatus RunCache::run(Cpu& cpu, const s32 cycles, Memory& memory)
+{
+    MemoryHash hash(memory);
+    return run(cpu, cycles, memory, hash);
+}
+
+template <typename Cpu>
+StopStatus RunCache::run(Cpu& cpu, const s32 cycles, Memory& memory, MemoryHash& hash)
+{
+    static_assert(std::is_same_v<typename Cpu::HooksType, NoHooks>,
+                  "The hooks of a cached run would never be called");
+
+    const Hash128 runKey = key(cpu, variantBits<typename Cpu::VariantType>(), cycles, hash);
+    if (const std::shared_ptr<const Result> result = find(runKey))
+    {
+        apply(*result, cpu, memory, hash);
+        cpu.advanceCycles(result->status.cycles);
+        return result->status;
+    }
+
+    const std::vector<u8> initial(memory.data.begin(), memory.data.end());
+    const StopStatus status = cpu.run(cycles, memory);
+    record(runKey, status, cpu, initial, memory, hash);
+    return status;
+}
+
+} // namespace c6502
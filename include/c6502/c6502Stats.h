@@ -0,0 +1,129 @@
+#pragma once
+
+#include "c6502/c6502.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+namespace c6502
+{
+/// A copy of the counters of a Stats, taken at one point in time
+struct StatsSnapshot
+{
+    u64 instructions = 0;    // Instructions retired
+    u64 cycles = 0;          // Cycles executed, overshoot included
+    u64 overshootCycles = 0; // Cycles executed past the budget of a run
+    u64 hostNanoseconds = 0; // Host time spent running the CPU
+    u64 runs = 0;            // Calls to run
+    u64 stalls = 0;          // Runs that ended at an invalid opcode, the CPU can't go on
+
+    /// Emulated clock rate the host achieved
+    double emulatedMHz() const
+    {
+        return hostNanoseconds > 0 ? cycles * 1e3 / hostNanoseconds : 0.0;
+    }
+};
+
+/* Counters of a machine, updated by the thread running it and readable from any other.
+ *
+ * The counters are relaxed atomics and only ever written by one thread, so an update is
+ * a plain load and store. They're updated per chunk of a run, never per instruction, and a
+ * snapshot may mix counters from two consecutive chunks.
+ */
+class Stats
+{
+public:
+    /// Adds a finished run with the budget it was given and the host time it took
+    void record(const StopStatus& status, const u64 budget, const u64 hostNanoseconds)
+    {
+        recordProgress(status.instructions, status.cycles, hostNanoseconds);
+        recordEnd(status, budget);
+    }
+
+    /// Adds the work of a part of a run that is still going
+    void recordProgress(const u64 instructions, const u64 cycles, const u64 hostNanoseconds)
+    {
+        add(m_instructions, instructions);
+        add(m_cycles, cycles);
+        add(m_hostNanoseconds, hostNanoseconds);
+    }
+
+    /// Ends a run whose work recordProgress added, status covers the whole run
+    void recordEnd(const StopStatus& status, const u64 budget)
+    {
+        add(m_overshootCycles, status.cycles > budget ? status.cycles - budget : 0);
+        add(m_runs, 1);
+        add(m_stalls, status.reason == StopReason::InvalidOpCode ? 1 : 0);
+    }
+
+    StatsSnapshot snapshot() const
+    {
+        StatsSnapshot snapshot;
+        snapshot.instructions = m_instructions.load(std::memory_order_relaxed);
+        snapshot.cycles = m_cycles.load(std::memory_order_relaxed);
+        snapshot.overshootCycles = m_overshootCycles.load(std::memory_order_relaxed);
+        snapshot.hostNanoseconds = m_hostNanoseconds.load(std::memory_order_relaxed);
+        snapshot.runs = m_runs.load(std::memory_order_relaxed);
+        snapshot.stalls = m_stalls.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+private:
+    static void add(std::atomic<u64>& counter, const u64 value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    std::atomic<u64> m_instructions{0};
+    std::atomic<u64> m_cycles{0};
+    std::atomic<u64> m_overshootCycles{0};
+    std::atomic<u64> m_hostNanoseconds{0};
+    std::atomic<u64> m_runs{0};
+    std::atomic<u64> m_stalls{0};
+};
+
+/// Cycles a measured run executes between two updates of its stats, a few milliseconds at
+/// most even with logging
+inline constexpr u64 c_statsChunkCycles = 64 * 1024;
+
+/// Runs the CPU like cpu.runUntil and records the run in stats as it goes, so that another
+/// thread sees a long run progress
+template <typename Cpu>
+StopStatus measuredRunUntil(Cpu& cpu, const u64 deadline, Memory& memory, Stats& stats)
+{
+    using Clock = std::chrono::steady_clock;
+
+    const u64 budget = deadline > cpu.cycles() ? deadline - cpu.cycles() : 0;
+    StopStatus status{StopReason::CyclesExhausted, 0, cpu.PC, 0, 0};
+    do
+    {
+        const u64 chunkDeadline = std::min(deadline, cpu.cycles() + c_statsChunkCycles);
+        const auto start = Clock::now();
+        const StopStatus chunk = cpu.runUntil(chunkDeadline, memory);
+        const auto elapsed = Clock::now() - start;
+
+        const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed);
+        stats.recordProgress(chunk.instructions,
+                             chunk.cycles,
+                             static_cast<u64>(nanoseconds.count()));
+
+        status.reason = chunk.reason;
+        status.opCode = chunk.opCode;
+        status.PC = chunk.PC;
+        status.cycles += chunk.cycles;
+        status.instructions += chunk.instructions;
+    } while (status.reason == StopReason::CyclesExhausted && cpu.cycles() < deadline);
+
+    stats.recordEnd(status, budget);
+    return status;
+}
+
+/// Runs the CPU like cpu.run and records the run in stats
+template <typename Cpu>
+StopStatus measuredRun(Cpu& cpu, const s32 cycles, Memory& memory, Stats& stats)
+{
+    return measuredRunUntil(cpu, cycles > 0 ? cpu.cycles() + cycles : cpu.cycles(), memory, stats);
+}
+
+} // namespace c6502
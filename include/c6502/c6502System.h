@@ -0,0 +1,137 @@
+#pragma once
+
+#include "c6502/c6502.h"
+#include "c6502/c6502Stats.h"
+
+#include <bitset>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace c6502
+{
+/// Logs the writes a CPU makes to shared pages so System can hand them to the other CPUs
+struct SharedBusHooks : public NoHooks
+{
+    void onWrite(const u16 address, const u8 value)
+    {
+        if (sharedPages->test(address >> 8))
+        {
+            writes.emplace_back(address, value);
+        }
+    }
+
+    const std::bitset<256>* sharedPages = nullptr;
+    std::vector<std::pair<u16, u8>> writes;
+};
+
+using SystemCpu = BasicCpu<Nmos6502, SharedBusHooks>;
+
+/* Several CPUs, each with a memory of its own, that share some of their pages.
+ *
+ * The CPUs run in lockstep quanta of cycles, each quantum on its own thread. Every CPU
+ * sees its own writes right away, writes to shared pages are logged and applied to every
+ * memory at the end of the quantum in CPU index order. A CPU therefore sees the others at
+ * most one quantum late and the outcome doesn't depend on how the threads are scheduled:
+ * running in parallel gives the same result as running serially. Shorter quanta mean
+ * tighter coupling between the CPUs but more synchronization.
+ *
+ * Quanta end at fixed deadlines on each CPU's cycle counter, so cycles a CPU overshoots a
+ * quantum by are taken off its next one. A CPU that hits an invalid opcode is halted and
+ * skipped from then on.
+ */
+class System
+{
+public:
+    System(std::size_t cpuCount, s32 quantum, bool parallel = true);
+    ~System();
+
+    System(const System&) = delete;
+    System& operator=(const System&) = delete;
+
+    std::size_t cpuCount() const
+    {
+        return m_nodes.size();
+    }
+
+    s32 quantum() const
+    {
+        return m_quantum;
+    }
+
+    SystemCpu& cpu(const std::size_t index)
+    {
+        return m_nodes[index]->cpu;
+    }
+
+    Memory& memory(const std::size_t index)
+    {
+        return *m_nodes[index]->memory;
+    }
+
+    /// How the CPU's last quantum ended
+    const StopStatus& status(const std::size_t index) const
+    {
+        return m_nodes[index]->status;
+    }
+
+    /// Counters of the CPU, safe to read while the system runs
+    const Stats& stats(const std::size_t index) const
+    {
+        return m_nodes[index]->stats;
+    }
+
+    bool isHalted(const std::size_t index) const
+    {
+        return m_nodes[index]->status.reason == StopReason::InvalidOpCode;
+    }
+
+    /// Shares a page between all CPUs, its contents are taken from the first CPU's memory
+    void sharePage(u8 page);
+
+    bool isShared(const u16 address) const
+    {
+        return m_sharedPages.test(address >> 8);
+    }
+
+    /// Writes to a shared page of every CPU, for use between runs
+    void writeShared(u16 address, u8 value);
+
+    /// Runs every CPU for the given cycles, rounded up to whole quanta
+    void run(s32 cycles);
+
+private:
+    struct Node
+    {
+        SystemCpu cpu;
+        std::unique_ptr<Memory> memory;
+        StopStatus status{};
+        u64 deadline = 0; // End of the current quantum on the CPU's clock
+        Stats stats;
+    };
+
+    void runQuantum(Node& node);
+
+    /// Applies the logged shared writes to every memory, in CPU index order
+    void synchronize();
+
+    void workerLoop(std::size_t index);
+
+    std::vector<std::unique_ptr<Node>> m_nodes;
+    std::bitset<256> m_sharedPages;
+    const s32 m_quantum;
+
+    // Quantum handshake between run() and the workers
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_quantumStarted;
+    std::condition_variable m_quantumDone;
+    u32 m_generation = 0;
+    std::size_t m_pending = 0;
+    bool m_stopping = false;
+};
+
+} // namespace c6502
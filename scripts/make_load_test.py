@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+"""Generates bench/load_test.bin, the self checking image the bench always runs.
+
+The image is 64 KB, loaded at $0000 and started at $0400 with the registers
+resetRegisters leaves (SP $FF, A, X, Y and SR 0). From $0400 it's one straight
+run of random loads, TXS and NOPs for the NMOS 6502
+(LDA, LDX and LDY in every addressing mode), with random operands
+that read all of memory, page crossings and zero page pointers at $FF
+included. It ends at the invalid opcode $FF.
+
+The expected outcome is computed here, by a model independent of the core, and
+stored little endian from $0200:
+
+    $0200 A, X, Y, SP, SR after the last instruction
+    $0205 address of the invalid opcode
+    $0207 cycles, the fetch of the invalid opcode included (u32)
+    $020B instructions, the invalid opcode not included (u32)
+
+Usage: make_load_test.py [output], default bench/load_test.bin
+"""
+
+import os
+import random
+import struct
+import sys
+
+PROGRAM_START = 0x0400
+PROGRAM_END = 0xFFF0
+RESULT_ADDRESS = 0x0200
+INVALID_OPCODE = 0xFF
+
+# opcode: (register, addressing mode)
+LOADS = {
+    0xA9: ("A", "imm"), 0xA5: ("A", "zp"), 0xB5: ("A", "zpx"), 0xAD: ("A", "abs"),
+    0xBD: ("A", "absx"), 0xB9: ("A", "absy"), 0xA1: ("A", "indx"), 0xB1: ("A", "indy"),
+    0xA2: ("X", "imm"), 0xA6: ("X", "zp"), 0xB6: ("X", "zpy"), 0xAE: ("X", "abs"),
+    0xBE: ("X", "absy"),
+    0xA0: ("Y", "imm"), 0xA4: ("Y", "zp"), 0xB4: ("Y", "zpx"), 0xAC: ("Y", "abs"),
+    0xBC: ("Y", "absx"),
+}
+TXS = 0x9A
+NOP = 0xEA
+
+OPERAND_BYTES = {"imm": 1, "zp": 1, "zpx": 1, "zpy": 1, "indx": 1, "indy": 1,
+                 "abs": 2, "absx": 2, "absy": 2}
+
+
+class Model:
+    def __init__(self, memory):
+        self.memory = memory
+        self.pc = PROGRAM_START
+        self.sp = 0xFF
+        self.regs = {"A": 0, "X": 0, "Y": 0}
+        self.sr = 0
+        self.cycles = 0
+        self.instructions = 0
+
+    def fetch(self):
+        value = self.memory[self.pc]
+        self.pc = (self.pc + 1) & 0xFFFF
+        return value
+
+    def zero_page_word(self, address):
+        return self.memory[address] | self.memory[(address + 1) & 0xFF] << 8
+
+    def operand(self, mode):
+        """Returns the operand value and the cycles of the instruction"""
+        if mode == "imm":
+            return self.fetch(), 2
+        if mode == "zp":
+            return self.memory[self.fetch()], 3
+        if mode in ("zpx", "zpy"):
+            index = self.regs["X" if mode == "zpx" else "Y"]
+            return self.memory[(self.fetch() + index) & 0xFF], 4
+        base = self.fetch()
+        if mode == "indx":
+            pointer = self.zero_page_word((base + self.regs["X"]) & 0xFF)
+            return self.memory[pointer], 6
+        if mode == "indy":
+            pointer = self.zero_page_word(base)
+            address = (pointer + self.regs["Y"]) & 0xFFFF
+            return self.memory[address], 5 + ((pointer ^ address) > 0xFF)
+        base |= self.fetch() << 8
+        if mode == "abs":
+            return self.memory[base], 4
+        index = self.regs["X" if mode == "absx" else "Y"]
+        address = (base + index) & 0xFFFF
+        return self.memory[address], 4 + ((base ^ address) > 0xFF)
+
+    def step(self):
+        """Executes one instruction, returns False at the invalid opcode"""
+        opCode = self.fetch()
+        if opCode in LOADS:
+            register, mode = LOADS[opCode]
+            value, cycles = self.operand(mode)
+            self.regs[register] = value
+            self.sr &= ~0x82 & 0xFF
+            self.sr |= (0x02 if value == 0 else 0) | (value & 0x80)
+        elif opCode == TXS:
+            self.sp = self.regs["X"]
+            cycles = 2
+        elif opCode == NOP:
+            cycles = 2
+        else:
+            assert opCode == INVALID_OPCODE
+            self.cycles += 1
+            return False
+        self.cycles += cycles
+        self.instructions += 1
+        return True
+
+
+def generate(seed=6502):
+    rng = random.Random(seed)
+    memory = bytearray(rng.randrange(256) for _ in range(0x10000))
+
+    opCodes = list(LOADS) + [TXS, NOP]
+    address = PROGRAM_START
+    while True:
+        opCode = rng.choice(opCodes)
+        length = 1 + OPERAND_BYTES.get(LOADS.get(opCode, (None, None))[1], 0)
+        if address + length > PROGRAM_END:
+            break
+        memory[address] = opCode
+        # Pointers at $FF and page crossings are made common enough to matter
+        if length > 1 and rng.random() < 0.1:
+            memory[address + 1] = 0xFF
+        address += length
+    end = address
+    memory[end] = INVALID_OPCODE
+
+    model = Model(memory)
+    while model.step():
+        pass
+    assert model.pc - 1 == end
+
+    result = struct.pack("<BBBBBHII", model.regs["A"], model.regs["X"], model.regs["Y"],
+                         model.sp, model.sr, end, model.cycles, model.instructions)
+    memory[RESULT_ADDRESS:RESULT_ADDRESS + len(result)] = result
+
+    # The result is data the program may read, so it's run again with it in place
+    check = Model(memory)
+    while check.step():
+        pass
+    recheck = struct.pack("<BBBBBHII", check.regs["A"], check.regs["X"], check.regs["Y"],
+                          check.sp, check.sr, end, check.cycles, check.instructions)
+    if recheck != result:
+        return None
+    return memory
+
+
+def main():
+    output = sys.argv[1] if len(sys.argv) > 1 else os.path.join(
+        os.path.dirname(__file__), "..", "bench", "load_test.bin")
+    seed = 6502
+    memory = generate(seed)
+    while memory is None:
+        seed += 1
+        memory = generate(seed)
+    with open(output, "wb") as file:
+        file.write(memory)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,84 @@
+#include "c6502/c6502Disassembler.h"
+
+#include <cstdio>
+
+namespace c6502
+{
+int format(const Instruction& instruction, char* buffer, const std::size_t size)
+{
+    if (!instruction.isValid())
+    {
+        return std::snprintf(buffer, size, ".byte $%02X", unsigned(instruction.opCode));
+    }
+
+    const int nameLength = static_cast<int>(instruction.info.mnemonic.size());
+    const char* name = instruction.info.mnemonic.data();
+    const unsigned operand = instruction.operand;
+    switch (instruction.info.mode)
+    {
+        case AddrMode::Implied:
+        {
+            return std::snprintf(buffer, size, "%.*s", nameLength, name);
+        }
+        case AddrMode::Accumulator:
+        {
+            return std::snprintf(buffer, size, "%.*s A", nameLength, name);
+        }
+        case AddrMode::Immediate:
+        {
+            return std::snprintf(buffer, size, "%.*s #$%02X", nameLength, name, operand);
+        }
+        case AddrMode::ZeroPage:
+        {
+            return std::snprintf(buffer, size, "%.*s $%02X", nameLength, name, operand);
+        }
+        case AddrMode::ZeroPageX:
+        {
+            return std::snprintf(buffer, size, "%.*s $%02X,X", nameLength, name, operand);
+        }
+        case AddrMode::ZeroPageY:
+        {
+            return std::snprintf(buffer, size, "%.*s $%02X,Y", nameLength, name, operand);
+        }
+        case AddrMode::Absolute:
+        {
+            return std::snprintf(buffer, size, "%.*s $%04X", nameLength, name, operand);
+        }
+        case AddrMode::AbsoluteX:
+        {
+            return std::snprintf(buffer, size, "%.*s $%04X,X", nameLength, name, operand);
+        }
+        case AddrMode::AbsoluteY:
+        {
+            return std::snprintf(buffer, size, "%.*s $%04X,Y", nameLength, name, operand);
+        }
+        case AddrMode::ZeroPageIndirect:
+        {
+            return std::snprintf(buffer, size, "%.*s ($%02X)", nameLength, name, operand);
+        }
+        case AddrMode::ZeroPageIndirectX:
+        {
+            return std::snprintf(buffer, size, "%.*s ($%02X,X)", nameLength, name, operand);
+        }
+        case AddrMode::ZeroPageIndirectY:
+        {
+            return std::snprintf(buffer, size, "%.*s ($%02X),Y", nameLength, name, operand);
+        }
+        case AddrMode::Relative:
+        {
+            const unsigned target = instruction.target();
+            return std::snprintf(buffer, size, "%.*s $%04X", nameLength, name, target);
+        }
+        case AddrMode::Indirect:
+        {
+            return std::snprintf(buffer, size, "%.*s ($%04X)", nameLength, name, operand);
+        }
+        case AddrMode::AbsoluteIndirectX:
+        {
+            return std::snprintf(buffer, size, "%.*s ($%04X,X)", nameLength, name, operand);
+        }
+    }
+    return 0;
+}
+
+} // namespace c6502
@@ -0,0 +1,333 @@
+#include "c6502/c6502Mapper.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+namespace c6502
+{
+namespace
+{
+constexpr std::size_t roundUpToPages(const std::size_t size)
+{
+    return (size + BankedMemory::c_pageSize - 1) & ~(BankedMemory::c_pageSize - 1);
+}
+
+/// Mirrors the RAM over $0000-$7FFF and leaves the ROM half unmapped
+void mapLowRam(BankedMemory& memory)
+{
+    if (memory.ramSize() > 0)
+    {
+        memory.mapRam(0x00, 0x80, 0);
+    }
+}
+} // namespace
+
+RomImage::RomImage(const u8* data, const std::size_t size)
+{
+    m_fd = memfd_create("c6502-rom", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (m_fd < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "memfd_create");
+    }
+    m_size = size;
+
+    for (std::size_t written = 0; written < size;)
+    {
+        const ssize_t result = pwrite(m_fd, data + written, size - written, written);
+        if (result < 0)
+        {
+            const int error = errno;
+            close(m_fd);
+            throw std::system_error(error, std::generic_category(), "pwrite");
+        }
+        written += static_cast<std::size_t>(result);
+    }
+
+    const int seals = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL;
+    if (fcntl(m_fd, F_ADD_SEALS, seals) < 0)
+    {
+        const int error = errno;
+        close(m_fd);
+        throw std::system_error(error, std::generic_category(), "F_ADD_SEALS");
+    }
+}
+
+RomImage::RomImage(const int fd, const std::size_t size) : m_fd(fd), m_size(size)
+{
+}
+
+RomImage RomImage::open(const char* path)
+{
+    const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), path);
+    }
+    return fromDescriptor(fd);
+}
+
+RomImage RomImage::fromDescriptor(const int fd)
+{
+    struct stat status;
+    if (fstat(fd, &status) < 0)
+    {
+        const int error = errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category(), "fstat");
+    }
+    return RomImage(fd, static_cast<std::size_t>(status.st_size));
+}
+
+RomImage::RomImage(RomImage&& other) noexcept
+    : m_fd(std::exchange(other.m_fd, -1))
+    , m_size(std::exchange(other.m_size, 0))
+{
+}
+
+RomImage& RomImage::operator=(RomImage&& other) noexcept
+{
+    if (this != &other)
+    {
+        if (m_fd >= 0)
+        {
+            close(m_fd);
+        }
+        m_fd = std::exchange(other.m_fd, -1);
+        m_size = std::exchange(other.m_size, 0);
+    }
+    return *this;
+}
+
+RomImage::~RomImage()
+{
+    if (m_fd >= 0)
+    {
+        close(m_fd);
+    }
+}
+
+BankedMemory::BankedMemory(const std::size_t romSize,
+                           const std::size_t ramSize,
+                           std::unique_ptr<Mapper> mapper)
+    : m_romSize(roundUpToPages(romSize))
+    , m_ramSize(roundUpToPages(ramSize))
+    , m_mapper(std::move(mapper))
+{
+    allocate(nullptr);
+    reset();
+}
+
+BankedMemory::BankedMemory(const RomImage& rom,
+                           const std::size_t ramSize,
+                           std::unique_ptr<Mapper> mapper)
+    : m_romSize(roundUpToPages(rom.size()))
+    , m_ramSize(roundUpToPages(ramSize))
+    , m_romShared(true)
+    , m_mapper(std::move(mapper))
+{
+    allocate(&rom);
+    reset();
+}
+
+void BankedMemory::allocate(const RomImage* rom)
+{
+    const std::size_t hostPageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    m_ramOffset = (m_romSize + hostPageSize - 1) / hostPageSize * hostPageSize;
+
+    // The zero page and the discard page follow the RAM
+    m_bufferSize = m_ramOffset + m_ramSize + 2 * c_pageSize;
+    void* buffer = mmap(nullptr,
+                        m_bufferSize,
+                        PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS,
+                        -1,
+                        0);
+    if (buffer == MAP_FAILED)
+    {
+        throw std::system_error(errno, std::generic_category(), "mmap");
+    }
+    m_buffer = static_cast<u8*>(buffer);
+
+    if (rom != nullptr && m_ramOffset > 0)
+    {
+        // Replaces the private ROM pages with the shared ones
+        void* shared = mmap(m_buffer,
+                            m_ramOffset,
+                            PROT_READ,
+                            MAP_SHARED | MAP_FIXED,
+                            rom->descriptor(),
+                            0);
+        if (shared == MAP_FAILED)
+        {
+            const int error = errno;
+            munmap(m_buffer, m_bufferSize);
+            throw std::system_error(error, std::generic_category(), "mmap");
+        }
+    }
+
+    m_zeroReads.fill(zeroPage());
+    m_discardWrites.fill(discardPage());
+    const std::size_t romSlots = (m_romSize + c_slotSize - 1) / c_slotSize;
+    m_romReads = std::make_unique<ReadTable[]>(romSlots);
+    for (std::size_t slot = 0; slot < romSlots; ++slot)
+    {
+        for (std::size_t i = 0; i < c_slotPages; ++i)
+        {
+            m_romReads[slot][i] = m_buffer + (slot * c_slotSize + i * c_pageSize) % m_romSize;
+        }
+    }
+}
+
+BankedMemory::~BankedMemory()
+{
+    munmap(m_buffer, m_bufferSize);
+}
+
+void BankedMemory::mapPage(const std::size_t page, const u8* read, u8* write)
+{
+    // The slot takes a copy of the tables it shows before one of its pages changes
+    const std::size_t slot = page / c_slotPages;
+    if (m_readSlots[slot] != &m_ownReads[slot])
+    {
+        m_ownReads[slot] = *m_readSlots[slot];
+        m_ownWrites[slot] = *m_writeSlots[slot];
+        m_readSlots[slot] = &m_ownReads[slot];
+        m_writeSlots[slot] = &m_ownWrites[slot];
+    }
+    m_ownReads[slot][page % c_slotPages] = read;
+    m_ownWrites[slot][page % c_slotPages] = write;
+}
+
+void BankedMemory::mapRom(const u8 firstPage, const std::size_t count, const std::size_t offset)
+{
+    assert(firstPage + count <= c_pageCount);
+    assert(offset % c_pageSize == 0);
+    if (m_romSize == 0)
+    {
+        unmap(firstPage, count);
+        return;
+    }
+
+    // Whole slots of a slot aligned bank point at the ROM's tables, the rest is mapped by page
+    std::size_t bank = offset % m_romSize;
+    for (std::size_t page = firstPage; page < firstPage + count;)
+    {
+        if (page % c_slotPages == 0 && firstPage + count - page >= c_slotPages &&
+            bank % c_slotSize == 0)
+        {
+            m_readSlots[page / c_slotPages] = &m_romReads[bank / c_slotSize];
+            m_writeSlots[page / c_slotPages] = &m_discardWrites;
+            page += c_slotPages;
+            bank += c_slotSize;
+        }
+        else
+        {
+            mapPage(page, rom() + bank, discardPage());
+            page += 1;
+            bank += c_pageSize;
+        }
+        bank = bank >= m_romSize ? bank % m_romSize : bank;
+    }
+}
+
+void BankedMemory::mapRam(const u8 firstPage, const std::size_t count, const std::size_t offset)
+{
+    assert(firstPage + count <= c_pageCount);
+    assert(offset % c_pageSize == 0);
+    if (m_ramSize == 0)
+    {
+        unmap(firstPage, count);
+        return;
+    }
+
+    std::size_t bank = offset % m_ramSize;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        mapPage(firstPage + i, ram() + bank, ram() + bank);
+        bank += c_pageSize;
+        bank = bank == m_ramSize ? 0 : bank;
+    }
+}
+
+void BankedMemory::unmap(const u8 firstPage, const std::size_t count)
+{
+    assert(firstPage + count <= c_pageCount);
+    for (std::size_t page = firstPage; page < firstPage + count;)
+    {
+        if (page % c_slotPages == 0 && firstPage + count - page >= c_slotPages)
+        {
+            m_readSlots[page / c_slotPages] = &m_zeroReads;
+            m_writeSlots[page / c_slotPages] = &m_discardWrites;
+            page += c_slotPages;
+        }
+        else
+        {
+            mapPage(page, zeroPage(), discardPage());
+            page += 1;
+        }
+    }
+}
+
+void BankedMemory::registerPages(const u8 firstPage, const std::size_t count)
+{
+    assert(firstPage + count <= c_pageCount);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        m_registerPages.set(firstPage + i);
+    }
+}
+
+void BankedMemory::reset()
+{
+    unmap(0x00, c_pageCount);
+    m_registerPages.reset();
+    m_mapper->reset(*this);
+}
+
+void NromMapper::reset(BankedMemory& memory)
+{
+    mapLowRam(memory);
+    memory.mapRom(0x80, 0x80, 0);
+}
+
+void NromMapper::writeRegister(BankedMemory& /*memory*/, const u16 /*address*/, const u8 /*value*/)
+{
+}
+
+void UxromMapper::reset(BankedMemory& memory)
+{
+    static constexpr std::size_t bankPages = c_bankSize / BankedMemory::c_pageSize;
+
+    mapLowRam(memory);
+    memory.mapRom(0x80, bankPages, 0);
+    const std::size_t lastBank = memory.romSize() > c_bankSize ? memory.romSize() - c_bankSize : 0;
+    memory.mapRom(0xC0, bankPages, lastBank);
+    memory.registerPages(0x80, 0x80);
+}
+
+void UxromMapper::writeRegister(BankedMemory& memory, const u16 /*address*/, const u8 value)
+{
+    static constexpr std::size_t bankPages = c_bankSize / BankedMemory::c_pageSize;
+    memory.mapRom(0x80, bankPages, value * c_bankSize);
+}
+
+void AxromMapper::reset(BankedMemory& memory)
+{
+    mapLowRam(memory);
+    memory.mapRom(0x80, 0x80, 0);
+    memory.registerPages(0x80, 0x80);
+}
+
+void AxromMapper::writeRegister(BankedMemory& memory, const u16 /*address*/, const u8 value)
+{
+    memory.mapRom(0x80, 0x80, value * c_bankSize);
+}
+
+} // namespace c6502
@@ -0,0 +1,119 @@
+#include "c6502/c6502Peripheral.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace c6502
+{
+void Scheduler::add(Device device)
+{
+    const std::coroutine_handle<> handle = device.handle();
+    m_devices.push_back(std::move(device));
+    handle.resume();
+}
+
+StopStatus Scheduler::run(const u64 cycles)
+{
+    const u64 end = now() + cycles;
+    StopStatus status{StopReason::CyclesExhausted, 0, m_cpu.PC, 0, 0};
+
+    resumeTimersUntil(now());
+    while (now() < end)
+    {
+        // Run the CPU up to the next timer, or until it makes an access a device waits for
+        const u64 until = m_timers.empty() ? end : std::min(end, m_timers.top().time);
+        if (until > now())
+        {
+            const StopStatus slice = measuredRunUntil(m_cpu, until, m_memory, m_stats);
+            status.PC = slice.PC;
+            status.cycles += slice.cycles;
+            status.instructions += slice.instructions;
+            deliverAccesses();
+
+            if (slice.reason == StopReason::InvalidOpCode)
+            {
+                status.reason = slice.reason;
+                status.opCode = slice.opCode;
+                return status;
+            }
+        }
+
+        resumeTimersUntil(now());
+    }
+
+    return status;
+}
+
+void Scheduler::wakeAt(const u64 time, const std::coroutine_handle<> handle)
+{
+    m_timers.push({time, m_sequence++, handle});
+}
+
+void Scheduler::wakeOnAccess(const u16 first,
+                             const u16 last,
+                             const std::coroutine_handle<> handle,
+                             BusAccess& access)
+{
+    m_watches.push_back({first, last, handle, &access});
+    updateWatchedPages();
+}
+
+void Scheduler::resumeAt(const u64 time, const std::coroutine_handle<> handle)
+{
+    m_resuming = true;
+    m_resumeTime = time;
+    handle.resume();
+    m_resuming = false;
+}
+
+void Scheduler::resumeTimersUntil(const u64 time)
+{
+    while (!m_timers.empty() && m_timers.top().time <= time)
+    {
+        const Timer timer = m_timers.top();
+        m_timers.pop();
+        resumeAt(timer.time, timer.handle);
+    }
+}
+
+void Scheduler::deliverAccesses()
+{
+    // A device that waits again right away sees the rest of the instruction's accesses
+    std::swap(m_accesses, m_cpu.accesses);
+    for (const BusAccess& access : m_accesses)
+    {
+        // Timers due up to the access come first, one due in the same cycle included
+        resumeTimersUntil(access.cycle);
+
+        m_delivering.clear();
+        const auto matches = [&access](const Watch& watch) {
+            return access.address >= watch.first && access.address <= watch.last;
+        };
+        std::copy_if(m_watches.begin(), m_watches.end(), std::back_inserter(m_delivering), matches);
+        m_watches.erase(std::remove_if(m_watches.begin(), m_watches.end(), matches),
+                        m_watches.end());
+
+        for (const Watch& watch : m_delivering)
+        {
+            *watch.access = access;
+            resumeAt(access.cycle, watch.handle);
+        }
+    }
+    m_accesses.clear();
+
+    updateWatchedPages();
+}
+
+void Scheduler::updateWatchedPages()
+{
+    m_cpu.watchedPages.reset();
+    for (const Watch& watch : m_watches)
+    {
+        for (unsigned page = watch.first >> 8; page <= unsigned(watch.last >> 8); ++page)
+        {
+            m_cpu.watchedPages.set(page);
+        }
+    }
+}
+
+} // namespace c6502
@@ -0,0 +1,345 @@
+#include "c6502/c6502RunCache.h"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <system_error>
+
+namespace c6502
+{
+namespace
+{
+constexpr u64 c_prime1 = 0x9E3779B185EBCA87;
+constexpr u64 c_prime2 = 0xC2B2AE3D27D4EB4F;
+constexpr u64 c_prime3 = 0x165667B19E3779F9;
+
+constexpr u64 c_pageSeed = 0x70616765;       // "page"
+constexpr u64 c_memorySeed = 0x6D656D6F7279; // "memory"
+constexpr u64 c_keySeed = 0x72756E;          // "run"
+
+/// Identifies a result file and the version of its layout
+constexpr char c_fileMagic[8] = {'c', '6', '5', '0', '2', 'r', 'u', 'n'};
+constexpr u32 c_fileVersion = 2;
+
+constexpr u64 rotateLeft(const u64 value, const int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+/// Makes every bit of the result depend on every bit of the value
+constexpr u64 avalanche(u64 value)
+{
+    value ^= value >> 33;
+    value *= c_prime2;
+    value ^= value >> 29;
+    value *= c_prime3;
+    value ^= value >> 32;
+    return value;
+}
+
+template <typename T>
+void writeValue(std::ofstream& file, const T& value)
+{
+    file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool readValue(std::ifstream& file, T& value)
+{
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+/* The status and registers are written field by field, their padding isn't part of the file
+ * and neither is anything else a change to the structs may add
+ */
+void writeStatus(std::ofstream& file, const StopStatus& status)
+{
+    writeValue(file, static_cast<u8>(status.reason));
+    writeValue(file, status.opCode);
+    writeValue(file, status.PC);
+    writeValue(file, status.cycles);
+    writeValue(file, status.instructions);
+}
+
+bool readStatus(std::ifstream& file, StopStatus& status)
+{
+    u8 reason = 0;
+    if (!readValue(file, reason) || reason > static_cast<u8>(StopReason::HookRequested))
+    {
+        return false;
+    }
+    status.reason = static_cast<StopReason>(reason);
+    return readValue(file, status.opCode) && readValue(file, status.PC) &&
+           readValue(file, status.cycles) && readValue(file, status.instructions);
+}
+
+void writeRegisters(std::ofstream& file, const CpuState& cpu)
+{
+    writeValue(file, cpu.PC);
+    writeValue(file, cpu.SP);
+    writeValue(file, cpu.A);
+    writeValue(file, cpu.X);
+    writeValue(file, cpu.Y);
+    writeValue(file, cpu.SR);
+}
+
+bool readRegisters(std::ifstream& file, CpuState& cpu)
+{
+    return readValue(file, cpu.PC) && readValue(file, cpu.SP) && readValue(file, cpu.A) &&
+           readValue(file, cpu.X) && readValue(file, cpu.Y) && readValue(file, cpu.SR);
+}
+} // namespace
+
+Hash128 Hash128::of(const u64* words, const std::size_t count, const u64 seed)
+{
+    // Two lanes with different constants, a collision has to happen in both
+    u64 low = seed + c_prime1;
+    u64 high = rotateLeft(seed, 32) + c_prime2;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        low = rotateLeft(low ^ (words[i] * c_prime2), 31) * c_prime1;
+        high = rotateLeft(high ^ (words[i] * c_prime3), 27) * c_prime2;
+    }
+
+    Hash128 hash;
+    hash.low = avalanche(low ^ count);
+    hash.high = avalanche(high + low);
+    return hash;
+}
+
+MemoryHash::MemoryHash(const Memory& memory)
+{
+    for (std::size_t page = 0; page < c_pageCount; ++page)
+    {
+        update(memory, static_cast<u8>(page));
+    }
+}
+
+void MemoryHash::update(const Memory& memory, const u8 page)
+{
+    u64 words[c_pageSize / sizeof(u64)];
+    std::memcpy(words, &memory.data[page * c_pageSize], c_pageSize);
+    m_pages[page] = Hash128::of(words, std::size(words), c_pageSeed);
+}
+
+Hash128 MemoryHash::combined() const
+{
+    u64 words[2 * c_pageCount];
+    for (std::size_t page = 0; page < c_pageCount; ++page)
+    {
+        words[2 * page] = m_pages[page].low;
+        words[2 * page + 1] = m_pages[page].high;
+    }
+    return Hash128::of(words, std::size(words), c_memorySeed);
+}
+
+RunCache::RunCache(const std::size_t capacityBytes, std::filesystem::path directory)
+    : m_capacityBytes(capacityBytes)
+    , m_directory(std::move(directory))
+{
+    if (!m_directory.empty())
+    {
+        std::filesystem::create_directories(m_directory);
+    }
+}
+
+RunCacheStats RunCache::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+Hash128 RunCache::key(const CpuState& cpu,
+                      const u64 variant,
+                      const s32 cycles,
+                      const MemoryHash& hash)
+{
+    const Hash128 memory = hash.combined();
+    const u64 registers = static_cast<u64>(cpu.PC) | static_cast<u64>(cpu.SP) << 16 |
+                          static_cast<u64>(cpu.A) << 24 | static_cast<u64>(cpu.X) << 32 |
+                          static_cast<u64>(cpu.Y) << 40 | static_cast<u64>(cpu.SR) << 48;
+    // No cycles at all runs like one, the budget is what run makes of it
+    const u64 budget = static_cast<u64>(cycles > 0 ? cycles : 0);
+
+    const u64 words[] = {memory.low, memory.high, registers, budget, variant};
+    return Hash128::of(words, std::size(words), c_keySeed);
+}
+
+std::shared_ptr<const RunCache::Result> RunCache::find(const Hash128& key)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto it = m_index.find(key);
+        if (it != m_index.end())
+        {
+            m_results.splice(m_results.begin(), m_results, it->second);
+            ++m_stats.hits;
+            return it->second->second;
+        }
+    }
+
+    if (m_directory.empty())
+    {
+        return nullptr;
+    }
+    std::shared_ptr<const Result> result = load(key);
+    if (result)
+    {
+        insert(key, result);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.diskHits;
+    }
+    return result;
+}
+
+void RunCache::apply(const Result& result, CpuState& cpu, Memory& memory, MemoryHash& hash)
+{
+    static_cast<CpuState&>(cpu) = result.registers;
+    for (std::size_t i = 0; i < result.pageIndices.size(); ++i)
+    {
+        const u8 page = result.pageIndices[i];
+        std::memcpy(&memory.data[page * MemoryHash::c_pageSize],
+                    &result.pages[i * MemoryHash::c_pageSize],
+                    MemoryHash::c_pageSize);
+        hash.update(memory, page);
+    }
+}
+
+void RunCache::record(const Hash128& key,
+                      const StopStatus& status,
+                      const CpuState& cpu,
+                      const std::vector<u8>& initial,
+                      const Memory& memory,
+                      MemoryHash& hash)
+{
+    auto result = std::make_shared<Result>();
+    result->status = status;
+    result->registers = cpu;
+    for (std::size_t page = 0; page < MemoryHash::c_pageCount; ++page)
+    {
+        const u8* before = &initial[page * MemoryHash::c_pageSize];
+        const u8* after = &memory.data[page * MemoryHash::c_pageSize];
+        if (std::memcmp(before, after, MemoryHash::c_pageSize) != 0)
+        {
+            result->pageIndices.push_back(static_cast<u8>(page));
+            result->pages.insert(result->pages.end(), after, after + MemoryHash::c_pageSize);
+            hash.update(memory, static_cast<u8>(page));
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.misses;
+    }
+    if (!m_directory.empty())
+    {
+        store(key, *result);
+    }
+    insert(key, std::move(result));
+}
+
+void RunCache::insert(const Hash128& key, std::shared_ptr<const Result> result)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Another thread may have made the same run
+    if (m_index.count(key) > 0)
+    {
+        return;
+    }
+
+    m_stats.bytes += result->bytes();
+    m_results.emplace_front(key, std::move(result));
+    m_index.emplace(key, m_results.begin());
+
+    // The result just made stays, even when it's larger than the capacity
+    while (m_stats.bytes > m_capacityBytes && m_results.size() > 1)
+    {
+        const Entry& oldest = m_results.back();
+        m_stats.bytes -= oldest.second->bytes();
+        ++m_stats.evictions;
+        m_index.erase(oldest.first);
+        m_results.pop_back();
+    }
+}
+
+std::filesystem::path RunCache::path(const Hash128& key) const
+{
+    char name[40];
+    std::snprintf(name,
+                  sizeof(name),
+                  "%016llx%016llx",
+                  static_cast<unsigned long long>(key.high),
+                  static_cast<unsigned long long>(key.low));
+    return m_directory / name;
+}
+
+std::shared_ptr<const RunCache::Result> RunCache::load(const Hash128& key) const
+{
+    std::ifstream file(path(key), std::ios::binary);
+    if (!file)
+    {
+        return nullptr;
+    }
+
+    // A file that's short or of another version is as good as none
+    char magic[sizeof(c_fileMagic)];
+    u32 version = 0;
+    u32 pageCount = 0;
+    auto result = std::make_shared<Result>();
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, c_fileMagic, sizeof(magic)) != 0 ||
+        !readValue(file, version) || version != c_fileVersion || !readStatus(file, result->status) ||
+        !readRegisters(file, result->registers) || !readValue(file, pageCount) ||
+        pageCount > MemoryHash::c_pageCount)
+    {
+        return nullptr;
+    }
+
+    result->pageIndices.resize(pageCount);
+    result->pages.resize(pageCount * MemoryHash::c_pageSize);
+    if (!file.read(reinterpret_cast<char*>(result->pageIndices.data()), pageCount) ||
+        !file.read(reinterpret_cast<char*>(result->pages.data()), result->pages.size()))
+    {
+        return nullptr;
+    }
+    return result;
+}
+
+void RunCache::store(const Hash128& key, const Result& result)
+{
+    // Written aside and renamed, a reader sees the whole file or none
+    const std::filesystem::path target = path(key);
+    std::filesystem::path temporary = target;
+    temporary += ".tmp" + std::to_string(getpid()) + "." + std::to_string(m_temporaryFiles++);
+
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(c_fileMagic, sizeof(c_fileMagic));
+        writeValue(file, c_fileVersion);
+        writeStatus(file, result.status);
+        writeRegisters(file, result.registers);
+        writeValue(file, static_cast<u32>(result.pageIndices.size()));
+        file.write(reinterpret_cast<const char*>(result.pageIndices.data()),
+                   result.pageIndices.size());
+        file.write(reinterpret_cast<const char*>(result.pages.data()), result.pages.size());
+        if (!file.flush())
+        {
+            // The cache works without the file, it's only missed by the next process
+            std::error_code error;
+            std::filesystem::remove(temporary, error);
+            return;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, target, error);
+    if (error)
+    {
+        std::filesystem::remove(temporary, error);
+    }
+}
+
+} // namespace c6502
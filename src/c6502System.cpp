@@ -0,0 +1,154 @@
+#include "c6502/c6502System.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace c6502
+{
+System::System(const std::size_t cpuCount, const s32 quantum, const bool parallel)
+    : m_quantum(quantum)
+{
+    assert(quantum > 0);
+
+    for (std::size_t i = 0; i < cpuCount; ++i)
+    {
+        auto node = std::make_unique<Node>();
+        node->memory = std::make_unique<Memory>();
+        node->memory->initialize();
+        node->cpu.sharedPages = &m_sharedPages;
+        m_nodes.push_back(std::move(node));
+    }
+
+    if (parallel && cpuCount > 1)
+    {
+        for (std::size_t i = 0; i < cpuCount; ++i)
+        {
+            m_workers.emplace_back(&System::workerLoop, this, i);
+        }
+    }
+}
+
+System::~System()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_quantumStarted.notify_all();
+
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+void System::sharePage(const u8 page)
+{
+    m_sharedPages.set(page);
+
+    const u16 pageStart = page << 8;
+    const u8* source = &(*m_nodes.front()->memory)[pageStart];
+    for (auto& node : m_nodes)
+    {
+        std::copy_n(source, 0x100, &(*node->memory)[pageStart]);
+    }
+}
+
+void System::writeShared(const u16 address, const u8 value)
+{
+    assert(isShared(address));
+
+    for (auto& node : m_nodes)
+    {
+        (*node->memory)[address] = value;
+    }
+}
+
+void System::run(const s32 cycles)
+{
+    // In 64 bits, cycles + m_quantum overflows an s32 for budgets near its maximum
+    const u64 budget = cycles > 0 ? static_cast<u64>(cycles) : 0;
+    const u64 quantum = static_cast<u64>(m_quantum);
+    const u64 quanta = (budget + quantum - 1) / quantum;
+    for (u64 i = 0; i < quanta; ++i)
+    {
+        if (m_workers.empty())
+        {
+            for (auto& node : m_nodes)
+            {
+                runQuantum(*node);
+            }
+        }
+        else
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_pending = m_nodes.size();
+            m_generation++;
+            m_quantumStarted.notify_all();
+            m_quantumDone.wait(lock, [this]() { return m_pending == 0; });
+        }
+
+        synchronize();
+    }
+}
+
+void System::runQuantum(Node& node)
+{
+    if (node.status.reason == StopReason::InvalidOpCode)
+    {
+        return;
+    }
+
+    // A CPU that overshot the last quantum's deadline starts this one late and stops on time
+    node.deadline += static_cast<u64>(m_quantum);
+    if (node.cpu.cycles() >= node.deadline)
+    {
+        return;
+    }
+
+    node.status = measuredRunUntil(node.cpu, node.deadline, *node.memory, node.stats);
+}
+
+void System::synchronize()
+{
+    for (auto& writer : m_nodes)
+    {
+        for (const auto& [address, value] : writer->cpu.writes)
+        {
+            for (auto& node : m_nodes)
+            {
+                (*node->memory)[address] = value;
+            }
+        }
+        writer->cpu.writes.clear();
+    }
+}
+
+void System::workerLoop(const std::size_t index)
+{
+    u32 generation = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_quantumStarted.wait(lock, [&]() {
+                return m_stopping || m_generation != generation;
+            });
+            if (m_stopping)
+            {
+                return;
+            }
+            generation = m_generation;
+        }
+
+        runQuantum(*m_nodes[index]);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_pending == 0)
+        {
+            m_quantumDone.notify_one();
+        }
+    }
+}
+
+} // namespace c6502
@@ -0,0 +1,394 @@
+/* Runner for the per opcode single step test corpus
+ * (https://github.com/SingleStepTests/65x02, 6502/v1).
+ *
+ * Every opcode has its own <opcode>.json file holding an array of test cases, each with
+ * the registers and RAM before and after one instruction plus the bus cycles it takes.
+ * The CPU runs cycle exact, so every bus access is checked against the cycles in order.
+ * Files are streamed through JsonReader one case at a time and the opcodes are shared
+ * out between the worker threads. Opcodes the CPU doesn't implement are skipped.
+ *
+ * Usage: c6502-conformance <corpus directory> [-j threads]
+ */
+
+#include "c6502/c6502.h"
+
+#include "json_reader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace c6502
+{
+namespace conformance
+{
+struct State
+{
+    u16 PC = 0;
+    u8 SP = 0;
+    u8 A = 0;
+    u8 X = 0;
+    u8 Y = 0;
+    u8 SR = 0;
+    std::vector<std::pair<u16, u8>> ram;
+};
+
+/// One bus cycle, an access the CPU makes
+struct BusAccess
+{
+    u16 address = 0;
+    u8 value = 0;
+    bool write = false;
+};
+
+bool operator==(const BusAccess& lhs, const BusAccess& rhs)
+{
+    return lhs.address == rhs.address && lhs.value == rhs.value && lhs.write == rhs.write;
+}
+
+struct TestCase
+{
+    std::string name;
+    State initial;
+    State final;
+    std::vector<BusAccess> cycles;
+};
+
+/// Records the bus accesses of an instruction
+struct BusTrace : public NoHooks
+{
+    void onRead(const u16 address, const u8 value)
+    {
+        accesses.push_back({address, value, false});
+    }
+
+    void onWrite(const u16 address, const u8 value)
+    {
+        accesses.push_back({address, value, true});
+    }
+
+    std::vector<BusAccess> accesses;
+};
+
+using ConformanceCpu = BasicCpu<Nmos6502, BusTrace>;
+
+struct Result
+{
+    u8 opCode = 0;
+    bool present = false;
+    std::size_t passed = 0;
+    std::size_t failed = 0;
+    std::string firstFailure;
+};
+
+void readState(JsonReader& reader, State& state)
+{
+    std::string key;
+    reader.beginObject();
+    while (reader.nextKey(key))
+    {
+        if (key == "pc")
+        {
+            state.PC = static_cast<u16>(reader.readInteger());
+        }
+        else if (key == "s")
+        {
+            state.SP = static_cast<u8>(reader.readInteger());
+        }
+        else if (key == "a")
+        {
+            state.A = static_cast<u8>(reader.readInteger());
+        }
+        else if (key == "x")
+        {
+            state.X = static_cast<u8>(reader.readInteger());
+        }
+        else if (key == "y")
+        {
+            state.Y = static_cast<u8>(reader.readInteger());
+        }
+        else if (key == "p")
+        {
+            state.SR = static_cast<u8>(reader.readInteger());
+        }
+        else if (key == "ram")
+        {
+            state.ram.clear();
+            reader.beginArray();
+            while (reader.nextElement())
+            {
+                reader.beginArray();
+                reader.nextElement();
+                const auto address = static_cast<u16>(reader.readInteger());
+                reader.nextElement();
+                const auto value = static_cast<u8>(reader.readInteger());
+                while (reader.nextElement())
+                {
+                    reader.skipValue();
+                }
+                state.ram.emplace_back(address, value);
+            }
+        }
+        else
+        {
+            reader.skipValue();
+        }
+    }
+}
+
+void readTestCase(JsonReader& reader, TestCase& testCase)
+{
+    std::string key;
+    reader.beginObject();
+    while (reader.nextKey(key))
+    {
+        if (key == "name")
+        {
+            reader.readString(testCase.name);
+        }
+        else if (key == "initial")
+        {
+            readState(reader, testCase.initial);
+        }
+        else if (key == "final")
+        {
+            readState(reader, testCase.final);
+        }
+        else if (key == "cycles")
+        {
+            testCase.cycles.clear();
+            reader.beginArray();
+            while (reader.nextElement())
+            {
+                BusAccess access;
+                std::string kind;
+                reader.beginArray();
+                reader.nextElement();
+                access.address = static_cast<u16>(reader.readInteger());
+                reader.nextElement();
+                access.value = static_cast<u8>(reader.readInteger());
+                reader.nextElement();
+                reader.readString(kind);
+                access.write = kind == "write";
+                while (reader.nextElement())
+                {
+                    reader.skipValue();
+                }
+                testCase.cycles.push_back(access);
+            }
+        }
+        else
+        {
+            reader.skipValue();
+        }
+    }
+}
+
+/// Runs one case, returns a description of what went wrong or an empty string
+std::string runTestCase(const TestCase& testCase, ConformanceCpu& cpu, Memory& memory)
+{
+    cpu.accesses.clear();
+    cpu.PC = testCase.initial.PC;
+    cpu.SP = testCase.initial.SP;
+    cpu.A = testCase.initial.A;
+    cpu.X = testCase.initial.X;
+    cpu.Y = testCase.initial.Y;
+    cpu.SR = testCase.initial.SR;
+    for (const auto& [address, value] : testCase.initial.ram)
+    {
+        memory[address] = value;
+    }
+
+    // A budget of one cycle executes exactly one instruction
+    const s32 cyclesUsed = cpu.execute(1, memory);
+
+    std::stringstream failure;
+    CpuState expected = cpu;
+    expected.PC = testCase.final.PC;
+    expected.SP = testCase.final.SP;
+    expected.A = testCase.final.A;
+    expected.X = testCase.final.X;
+    expected.Y = testCase.final.Y;
+    expected.SR = testCase.final.SR;
+    if (static_cast<const CpuState&>(cpu) != expected)
+    {
+        failure << "\n    expected " << expected << "\n    actual   "
+                << static_cast<const CpuState&>(cpu);
+    }
+    if (cyclesUsed != static_cast<s32>(testCase.cycles.size()))
+    {
+        failure << "\n    expected " << testCase.cycles.size() << " cycles, used " << cyclesUsed;
+    }
+    else if (cpu.accesses != testCase.cycles)
+    {
+        for (std::size_t i = 0; i < testCase.cycles.size(); ++i)
+        {
+            const BusAccess& expectedAccess = testCase.cycles[i];
+            const BusAccess& access = cpu.accesses[i];
+            if (!(access == expectedAccess))
+            {
+                failure << "\n    cycle " << i << " expected " << unsigned(expectedAccess.value)
+                        << (expectedAccess.write ? " written to " : " read from ")
+                        << expectedAccess.address << ", was " << unsigned(access.value)
+                        << (access.write ? " written to " : " read from ") << access.address;
+                break;
+            }
+        }
+    }
+    for (const auto& [address, value] : testCase.final.ram)
+    {
+        if (memory[address] != value)
+        {
+            failure << "\n    expected " << unsigned(value) << " at " << address << ", found "
+                    << unsigned(memory[address]);
+        }
+    }
+
+    // Only the touched bytes need to be cleared for the next case
+    for (const auto& [address, value] : testCase.initial.ram)
+    {
+        memory[address] = 0;
+    }
+    for (const auto& [address, value] : testCase.final.ram)
+    {
+        memory[address] = 0;
+    }
+
+    return failure.str();
+}
+
+void runOpCode(const std::string& directory,
+               Result& result,
+               ConformanceCpu& cpu,
+               Memory& memory)
+{
+    char fileName[8];
+    std::snprintf(fileName, sizeof(fileName), "%02x.json", unsigned(result.opCode));
+    const std::string path = directory + "/" + fileName;
+
+    std::unique_ptr<std::FILE, int (*)(std::FILE*)> file(std::fopen(path.c_str(), "rb"),
+                                                         std::fclose);
+    if (!file)
+    {
+        return;
+    }
+    result.present = true;
+
+    try
+    {
+        JsonReader reader(file.get());
+        TestCase testCase;
+
+        reader.beginArray();
+        while (reader.nextElement())
+        {
+            readTestCase(reader, testCase);
+
+            const std::string failure = runTestCase(testCase, cpu, memory);
+            if (failure.empty())
+            {
+                result.passed++;
+            }
+            else if (result.failed++ == 0)
+            {
+                result.firstFailure = "'" + testCase.name + "'" + failure;
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        result.failed++;
+        result.firstFailure = path + ": " + e.what();
+    }
+}
+
+} // namespace conformance
+} // namespace c6502
+
+int main(int argc, char* argv[])
+{
+    using namespace c6502;
+    using namespace c6502::conformance;
+
+    std::string directory;
+    unsigned threadCount = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string argument = argv[i];
+        if (argument == "-j" && i + 1 < argc)
+        {
+            threadCount = std::max(1, std::atoi(argv[++i]));
+        }
+        else
+        {
+            directory = argument;
+        }
+    }
+    if (directory.empty())
+    {
+        std::fprintf(stderr, "Usage: %s <corpus directory> [-j threads]\n", argv[0]);
+        return 2;
+    }
+
+    // The core traces every access to stdout
+    std::cout.setstate(std::ios_base::badbit);
+
+    std::vector<Result> results;
+    for (unsigned opCode = 0; opCode <= 0xFF; ++opCode)
+    {
+        if (Cpu::isValidOpCode(static_cast<u8>(opCode)))
+        {
+            Result result;
+            result.opCode = static_cast<u8>(opCode);
+            results.push_back(result);
+        }
+    }
+
+    std::atomic<std::size_t> nextResult{0};
+    std::vector<std::thread> workers;
+    for (unsigned worker = 0; worker < threadCount; ++worker)
+    {
+        workers.emplace_back([&]() {
+            ConformanceCpu cpu;
+            auto memory = std::make_unique<Memory>();
+            memory->initialize();
+
+            for (std::size_t i = nextResult++; i < results.size(); i = nextResult++)
+            {
+                runOpCode(directory, results[i], cpu, *memory);
+            }
+        });
+    }
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    std::size_t passed = 0;
+    std::size_t failed = 0;
+    std::size_t opCodes = 0;
+    for (const Result& result : results)
+    {
+        passed += result.passed;
+        failed += result.failed;
+        opCodes += result.present;
+        if (result.failed > 0)
+        {
+            std::printf("%02x: %zu of %zu failed, first %s\n",
+                        unsigned(result.opCode),
+                        result.failed,
+                        result.failed + result.passed,
+                        result.firstFailure.c_str());
+        }
+    }
+
+    std::printf("%zu opcodes, %zu passed, %zu failed\n", opCodes, passed, failed);
+    return (failed == 0 && opCodes > 0) ? 0 : 1;
+}
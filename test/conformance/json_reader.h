@@ -0,0 +1,212 @@
+#pragma once
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+namespace c6502
+{
+namespace conformance
+{
+/* Pull parser for JSON read straight from a file.
+ *
+ * Nothing is kept but the current buffer, the caller walks the document with
+ * beginArray/nextElement and beginObject/nextKey and reads the values it is interested
+ * in, everything else is skipped. Only what the single step test corpus uses is
+ * supported: no escapes beyond \" and \\, no floating point numbers.
+ */
+class JsonReader
+{
+public:
+    explicit JsonReader(std::FILE* file) : m_file(file)
+    {
+    }
+
+    void beginArray()
+    {
+        expect('[');
+    }
+
+    /// Steps to the next array element, false when the end of the array is reached
+    bool nextElement()
+    {
+        skipWhitespace();
+        if (peek() == ']')
+        {
+            get();
+            return false;
+        }
+        if (peek() == ',')
+        {
+            get();
+        }
+        return true;
+    }
+
+    void beginObject()
+    {
+        expect('{');
+    }
+
+    /// Reads the next key of an object, false when the end of the object is reached
+    bool nextKey(std::string& key)
+    {
+        skipWhitespace();
+        if (peek() == '}')
+        {
+            get();
+            return false;
+        }
+        if (peek() == ',')
+        {
+            get();
+        }
+        readString(key);
+        expect(':');
+        return true;
+    }
+
+    long readInteger()
+    {
+        skipWhitespace();
+        const bool negative = peek() == '-';
+        if (negative)
+        {
+            get();
+        }
+        if (!isDigit(peek()))
+        {
+            fail("expected a number");
+        }
+
+        long value = 0;
+        while (isDigit(peek()))
+        {
+            value = value * 10 + (get() - '0');
+        }
+        return negative ? -value : value;
+    }
+
+    void readString(std::string& value)
+    {
+        expect('"');
+        value.clear();
+        for (int c = get(); c != '"'; c = get())
+        {
+            if (c == '\\')
+            {
+                c = get();
+            }
+            if (c == EOF)
+            {
+                fail("unterminated string");
+            }
+            value += static_cast<char>(c);
+        }
+    }
+
+    void skipValue()
+    {
+        skipWhitespace();
+        switch (peek())
+        {
+            case '[':
+            {
+                beginArray();
+                while (nextElement())
+                {
+                    skipValue();
+                }
+                break;
+            }
+            case '{':
+            {
+                beginObject();
+                while (nextKey(m_skippedKey))
+                {
+                    skipValue();
+                }
+                break;
+            }
+            case '"':
+            {
+                readString(m_skippedKey);
+                break;
+            }
+            default:
+            {
+                // Numbers and literals
+                while (peek() != ',' && peek() != ']' && peek() != '}' && peek() != EOF)
+                {
+                    get();
+                }
+            }
+        }
+    }
+
+private:
+    static bool isDigit(const int c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    int peek()
+    {
+        if (m_pos == m_end && !refill())
+        {
+            return EOF;
+        }
+        return static_cast<unsigned char>(m_buffer[m_pos]);
+    }
+
+    int get()
+    {
+        const int c = peek();
+        if (c != EOF)
+        {
+            m_pos++;
+            m_offset++;
+        }
+        return c;
+    }
+
+    bool refill()
+    {
+        m_pos = 0;
+        m_end = std::fread(m_buffer, 1, sizeof(m_buffer), m_file);
+        return m_end > 0;
+    }
+
+    void skipWhitespace()
+    {
+        while (peek() == ' ' || peek() == '\n' || peek() == '\r' || peek() == '\t')
+        {
+            get();
+        }
+    }
+
+    void expect(const char expected)
+    {
+        skipWhitespace();
+        if (get() != expected)
+        {
+            fail(std::string("expected '") + expected + "'");
+        }
+    }
+
+    [[noreturn]] void fail(const std::string& message) const
+    {
+        throw std::runtime_error("JSON error at offset " + std::to_string(m_offset) + ": " +
+                                 message);
+    }
+
+    std::FILE* m_file;
+    char m_buffer[64 * 1024];
+    std::size_t m_pos = 0;
+    std::size_t m_end = 0;
+    std::size_t m_offset = 0;
+    std::string m_skippedKey;
+};
+
+} // namespace conformance
+} // namespace c6502
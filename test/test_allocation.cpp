@@ -0,0 +1,190 @@
+#include "test_c6502.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+std::atomic<std::size_t> allocations{0};
+
+void* allocate(const std::size_t size, const std::size_t alignment = 0) noexcept
+{
+    allocations++;
+    if (alignment <= alignof(std::max_align_t))
+    {
+        return std::malloc(size == 0 ? 1 : size);
+    }
+    // aligned_alloc wants a multiple of the alignment
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+void* allocateOrThrow(const std::size_t size, const std::size_t alignment = 0)
+{
+    if (void* ptr = allocate(size, alignment))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+} // namespace
+
+/* Counts every allocation made through global operator new in this executable, which has
+ * none of the other tests in it. Every form is replaced, so that no allocation of the
+ * library's operator new ends up in the free below, sanitizers treat that as a mismatch.
+ */
+void* operator new(const std::size_t size)
+{
+    return allocateOrThrow(size);
+}
+
+void* operator new[](const std::size_t size)
+{
+    return allocateOrThrow(size);
+}
+
+void* operator new(const std::size_t size, const std::align_val_t alignment)
+{
+    return allocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](const std::size_t size, const std::align_val_t alignment)
+{
+    return allocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new(const std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new[](const std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new(const std::size_t size,
+                   const std::align_val_t alignment,
+                   const std::nothrow_t&) noexcept
+{
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](const std::size_t size,
+                     const std::align_val_t alignment,
+                     const std::nothrow_t&) noexcept
+{
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+
+namespace c6502
+{
+TEST_CASE_METHOD(CpuFixture, "Execution does not allocate")
+{
+    GIVEN("A program using every addressing mode")
+    {
+        // clang-format off
+        const u8 program[] = {
+            Cpu::OP::LDX_IM,      0x01,
+            Cpu::OP::LDY_IM,      0x01,
+            Cpu::OP::LDA_ZP,      0x10,
+            Cpu::OP::LDA_ZPX,     0x10,
+            Cpu::OP::LDA_ABS,     0x34, 0x12,
+            Cpu::OP::LDA_ABSX,    0xFF, 0x12,
+            Cpu::OP::LDA_ABSY,    0x34, 0x12,
+            Cpu::OP::LDA_IND_ZPX, 0x3F,
+            Cpu::OP::LDA_IND_ZPY, 0x40,
+            Cpu::OP::TXS,
+            Cpu::OP::NOP,
+        };
+        // clang-format on
+        std::copy(std::begin(program), std::end(program), &memory[startAddr]);
+        memory[0x0040] = 0xFF;
+        memory[0x0041] = 0x12;
+
+        // Let the standard streams set up their buffers before counting
+        cpu.run(1000, memory);
+        cpu.resetRegisters(startAddr);
+
+        WHEN("It runs to the invalid opcode behind it")
+        {
+            const std::size_t allocationsBefore = allocations;
+            const StopStatus status = cpu.run(1000, memory);
+            char buffer[64];
+            cpu.format(buffer, sizeof(buffer));
+            const std::string_view name = Cpu::OpCodeToString(Cpu::OP::LDA_IND_ZPY);
+            const std::size_t allocationsAfter = allocations;
+
+            THEN("Nothing is allocated")
+            {
+                REQUIRE(status.reason == StopReason::InvalidOpCode);
+                REQUIRE(status.PC == startAddr + sizeof(program));
+                REQUIRE(name == "LDA_IND_ZPY");
+                REQUIRE(allocationsAfter == allocationsBefore);
+            }
+        }
+    }
+}
+
+} // namespace c6502
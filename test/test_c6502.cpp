@@ -1,5 +1,7 @@
 #include "test_c6502.h"
 
+#include <algorithm>
+
 namespace c6502
 {
 TEST_CASE_METHOD(CpuFixture, "CPU and memory reset")
@@ -22,14 +24,17 @@ TEST_CASE_METHOD(CpuFixture, "CPU and memory reset")
     REQUIRE(cpu.O == 0);
     REQUIRE(cpu.N == 0);
 
-    // Check that memory is initialized to zeros
+    // Check that memory is initialized to zeros, apart from the reset vector
+    REQUIRE(memory[CpuState::c_reset_vector] == (startAddr & 0xFF));
+    REQUIRE(memory[CpuState::c_reset_vector + 1] == (startAddr >> 8));
     const int sumOfAllAdresses = std::accumulate(std::begin(memory.data), std::end(memory.data), 0);
-    REQUIRE(sumOfAllAdresses == 0);
+    REQUIRE(sumOfAllAdresses == (startAddr & 0xFF) + (startAddr >> 8));
 
     // Make sure that a reset is resetting everything correctly
     takeSnapshot();
     cpu.reset(memory, 0x2000);
     cpuCopy.PC = 0x2000;
+    memoryCopy[CpuState::c_reset_vector + 1] = 0x20;
 
     REQUIRE(cpu == cpuCopy);
     REQUIRE(memory == memoryCopy);
@@ -59,6 +64,45 @@ TEST_CASE_METHOD(CpuFixture, "No cycles")
     }
 }
 
+TEST_CASE_METHOD(CpuFixture, "Cycle counter and deadlines")
+{
+    GIVEN("A program of NOPs")
+    {
+        std::fill_n(&memory[startAddr], 0x100, static_cast<u8>(Cpu::OP::NOP));
+
+        WHEN("Run several times")
+        {
+            cpu.execute(3, memory);
+            cpu.run(4, memory);
+            cpu.resetRegisters(startAddr);
+            const StopStatus status = cpu.run(0, memory);
+
+            THEN("The counter keeps every cycle, overshoot included, across resets")
+            {
+                REQUIRE(status.cycles == 0);
+                REQUIRE(cpu.cycles() == 4 + 4);
+            }
+        }
+
+        WHEN("Run until a deadline")
+        {
+            const StopStatus first = cpu.runUntil(5, memory);
+            const StopStatus second = cpu.runUntil(10, memory);
+            const StopStatus past = cpu.runUntil(9, memory);
+
+            THEN("Each run stops at the first instruction boundary at or past its deadline")
+            {
+                REQUIRE(first.cycles == 6);
+                REQUIRE(second.cycles == 4);
+                REQUIRE(past.cycles == 0);
+                REQUIRE(past.reason == StopReason::CyclesExhausted);
+                REQUIRE(cpu.cycles() == 10);
+                REQUIRE(cpu.PC == startAddr + 5);
+            }
+        }
+    }
+}
+
 TEST_CASE_METHOD(CpuFixture, "Execute invalid instruction result in exception")
 {
     REQUIRE_THROWS_AS(cpu.execute(1, memory), InvalidOpCode);
@@ -118,4 +162,38 @@ TEST_CASE_METHOD(CpuFixture, "TXS")
     }
 }
 
+TEST_CASE_METHOD(CpuFixture, "Run stops at an invalid opcode")
+{
+    GIVEN("A NOP followed by an invalid opcode")
+    {
+        memory[startAddr] = Cpu::OP::NOP;
+        memory[startAddr + 1] = 0xFF;
+
+        WHEN("Run with plenty of cycles")
+        {
+            const StopStatus status = cpu.run(100, memory);
+
+            THEN("The invalid opcode is reported instead of thrown")
+            {
+                REQUIRE(status.reason == StopReason::InvalidOpCode);
+                REQUIRE(status.opCode == 0xFF);
+                REQUIRE(status.PC == startAddr + 1);
+                REQUIRE(status.cycles == 3);
+            }
+        }
+
+        WHEN("Run with only the cycles for the NOP")
+        {
+            const StopStatus status = cpu.run(2, memory);
+
+            THEN("The budget runs out first")
+            {
+                REQUIRE(status.reason == StopReason::CyclesExhausted);
+                REQUIRE(status.PC == startAddr + 1);
+                REQUIRE(status.cycles == 2);
+            }
+        }
+    }
+}
+
 } // namespace c6502
@@ -0,0 +1,95 @@
+#include "test_c6502.h"
+
+namespace c6502
+{
+namespace
+{
+struct Result
+{
+    CpuState cpu;
+    StopStatus status;
+};
+
+/// Runs a program placed at $0200 with X, Y and a zero page pointer at $40 set up
+template <std::size_t N>
+constexpr Result runProgram(const u8 (&program)[N],
+                            const s32 cycles,
+                            const u8 X = 0,
+                            const u8 Y = 0)
+{
+    Memory memory{};
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        memory[0x0200 + i] = program[i];
+    }
+    memory[0x0040] = 0xFF;
+    memory[0x0041] = 0x12;
+    memory[0x12FF] = 0x81;
+    memory[0x1300] = 0x7F;
+
+    Cpu cpu{};
+    cpu.resetRegisters(0x0200);
+    cpu.X = X;
+    cpu.Y = Y;
+    const StopStatus status = cpu.run(cycles, memory);
+
+    return {cpu, status};
+}
+
+/// Cycles an instruction takes, measured by running it
+constexpr s32 cyclesOf(const u8 opCode, const u8 index)
+{
+    const u8 program[] = {opCode, 0x40, 0x12};
+    return runProgram(program, 1, index, index).status.cycles;
+}
+
+/// Table of the value LDA_IND_ZPY loads for every Y, built by the CPU at compile time
+constexpr std::array<u8, 4> makeIndirectTable()
+{
+    std::array<u8, 4> table{};
+    for (u8 Y = 0; Y < table.size(); ++Y)
+    {
+        const u8 program[] = {Cpu::OP::LDA_IND_ZPY, 0x40};
+        table[Y] = runProgram(program, 1, 0, Y).cpu.A;
+    }
+    return table;
+}
+
+constexpr u8 c_loadProgram[] = {Cpu::OP::LDX_IM, 0x80, Cpu::OP::TXS, Cpu::OP::LDY_ABS, 0xFF, 0x12,
+                                Cpu::OP::LDA_IM, 0x00, 0xFF};
+constexpr Result c_loadResult = runProgram(c_loadProgram, 100);
+
+static_assert(c_loadResult.status.reason == StopReason::InvalidOpCode);
+static_assert(c_loadResult.status.PC == 0x0208);
+static_assert(c_loadResult.status.cycles == 2 + 2 + 4 + 2 + 1);
+static_assert(c_loadResult.cpu.SP == 0x80 && c_loadResult.cpu.Y == 0x81);
+static_assert(c_loadResult.cpu.SR == CpuState::c_zeroFlag);
+
+static_assert(cyclesOf(Cpu::OP::LDA_ABSX, 0) == 4);
+static_assert(cyclesOf(Cpu::OP::LDA_ABSX, 0xFF) == 5);
+static_assert(cyclesOf(Cpu::OP::LDA_IND_ZPY, 1) == 6);
+static_assert(cyclesOf(Cpu::OP::LDA_IND_ZPX, 0) == 6);
+
+constexpr std::array<u8, 4> c_indirectTable = makeIndirectTable();
+static_assert(c_indirectTable[0] == 0x81 && c_indirectTable[1] == 0x7F);
+} // namespace
+
+TEST_CASE("The CPU gives the same results at compile time and at run time")
+{
+    GIVEN("A program of loads")
+    {
+        WHEN("Run at run time")
+        {
+            const Result result = runProgram(c_loadProgram, 100);
+
+            THEN("The state matches the one computed at compile time")
+            {
+                REQUIRE(result.cpu == c_loadResult.cpu);
+                REQUIRE(result.status.cycles == c_loadResult.status.cycles);
+                REQUIRE(makeIndirectTable() == c_indirectTable);
+            }
+        }
+    }
+}
+
+} // namespace c6502
@@ -0,0 +1,102 @@
+#include "test_c6502.h"
+
+#include "c6502/c6502ControlFlow.h"
+
+#include <vector>
+
+namespace c6502
+{
+TEST_CASE_METHOD(CpuFixture, "Control flow graph from the vectors")
+{
+    GIVEN("A program with a counted loop, a subroutine, an idle loop and an interrupt handler")
+    {
+        const u8 program[] = {
+            0xA2, 0x10,       // $0200 LDX #$10
+            0xBD, 0x00, 0x03, // $0202 LDA $0300,X
+            0xCA,             // $0205 DEX
+            0xD0, 0xFA,       // $0206 BNE $0202
+            0x20, 0x10, 0x02, // $0208 JSR $0210
+            0x4C, 0x0B, 0x02, // $020B JMP $020B
+            0xFF, 0xFF,       // $020E Data
+            0xA4, 0x80,       // $0210 LDY $80
+            0x60,             // $0212 RTS
+            0x40,             // $0213 RTI
+        };
+        std::copy(std::begin(program), std::end(program), &memory[0x0200]);
+        memory[CpuState::c_reset_vector] = 0x00;
+        memory[CpuState::c_reset_vector + 1] = 0x02;
+        memory[CpuState::c_nmi_vector] = 0x13;
+        memory[CpuState::c_nmi_vector + 1] = 0x02;
+        memory[CpuState::c_irq_vector] = 0x13;
+        memory[CpuState::c_irq_vector + 1] = 0x02;
+
+        WHEN("Analyzed")
+        {
+            const ControlFlowGraph<Nmos6502> graph(memory);
+
+            THEN("Every block is found with its successors")
+            {
+                std::vector<u16> starts;
+                for (const BasicBlock& block : graph.blocks())
+                {
+                    starts.push_back(block.start);
+                }
+                const std::vector<u16> expected = {0x0200, 0x0202, 0x0208, 0x020B, 0x0210, 0x0213};
+                REQUIRE(starts == expected);
+
+                const BasicBlock* loop = graph.blockAt(0x0202);
+                REQUIRE(loop != nullptr);
+                REQUIRE(loop->instructions == 3);
+                REQUIRE(loop->last == 0x0206);
+                REQUIRE(loop->end == 0x0208);
+                REQUIRE(loop->exit == Flow::Branch);
+                REQUIRE(loop->successorCount == 2);
+                REQUIRE(loop->hasSuccessor(0x0202));
+                REQUIRE(loop->hasSuccessor(0x0208));
+
+                REQUIRE(graph.blockAt(0x0200)->successorCount == 1);
+                REQUIRE(graph.blockAt(0x0200)->hasSuccessor(0x0202));
+                REQUIRE(graph.blockAt(0x0208)->hasSuccessor(0x0210));
+                REQUIRE(graph.blockAt(0x0208)->hasSuccessor(0x020B));
+                REQUIRE(graph.blockAt(0x0210)->exit == Flow::Return);
+                REQUIRE(graph.blockAt(0x0210)->successorCount == 0);
+                REQUIRE(graph.blockAt(0x020E) == nullptr);
+            }
+
+            THEN("The counted loop and the idle loop are loop headers")
+            {
+                REQUIRE(graph.loopHeaders() == std::vector<u16>{0x0202, 0x020B});
+            }
+
+            THEN("Code and data pages are told apart")
+            {
+                REQUIRE(graph.isCodePage(0x02));
+                REQUIRE_FALSE(graph.isCodePage(0x03));
+                REQUIRE(graph.isDataPage(0x03));
+                REQUIRE(graph.isDataPage(0x00));
+                REQUIRE_FALSE(graph.isDataPage(0x02));
+            }
+        }
+    }
+
+    GIVEN("Code that runs into an invalid opcode")
+    {
+        memory[startAddr] = Cpu::OP::NOP;
+        memory[startAddr + 1] = 0xFF;
+
+        WHEN("Analyzed from its start")
+        {
+            const ControlFlowGraph<Nmos6502> graph(memory, {startAddr});
+
+            THEN("The block ends there without successors")
+            {
+                REQUIRE(graph.blocks().size() == 1);
+                REQUIRE(graph.blocks().front().exit == Flow::Invalid);
+                REQUIRE(graph.blocks().front().successorCount == 0);
+                REQUIRE(graph.loopHeaders().empty());
+            }
+        }
+    }
+}
+
+} // namespace c6502
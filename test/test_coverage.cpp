@@ -0,0 +1,82 @@
+#include "test_c6502.h"
+
+#include "c6502/c6502Coverage.h"
+
+#include <numeric>
+#include <vector>
+
+namespace c6502
+{
+class CpuFixtureCoverage : public CpuFixture
+{
+public:
+    CpuFixtureCoverage() : map(EdgeCoverage::MAP_SIZE, 0), coverage(map.data())
+    {
+    }
+
+    u8 hits(const u16 fromPC, const u16 toPC) const
+    {
+        const u16 edge = (EdgeCoverage::location(fromPC) >> 1) ^ EdgeCoverage::location(toPC);
+        return map[edge];
+    }
+
+    std::vector<u8> map;
+    EdgeCoverage coverage;
+};
+
+TEST_CASE_METHOD(CpuFixtureCoverage, "Edge coverage")
+{
+    GIVEN("Two NOPs followed by TXS")
+    {
+        memory[startAddr] = Cpu::OP::NOP;
+        memory[startAddr + 1] = Cpu::OP::NOP;
+        memory[startAddr + 2] = Cpu::OP::TXS;
+
+        const s32 cyclesExpected = 6;
+
+        WHEN("Executed with coverage")
+        {
+            const s32 cyclesUsed = cpu.execute(cyclesExpected, memory, coverage);
+
+            THEN("Every edge between the instructions is hit once")
+            {
+                REQUIRE(cyclesUsed == cyclesExpected);
+                REQUIRE(map[EdgeCoverage::location(startAddr)] == 1);
+                REQUIRE(hits(startAddr, startAddr + 1) == 1);
+                REQUIRE(hits(startAddr + 1, startAddr + 2) == 1);
+
+                const int totalHits = std::accumulate(std::begin(map), std::end(map), 0);
+                REQUIRE(totalHits == 3);
+            }
+        }
+
+        WHEN("Executed with and without coverage")
+        {
+            Cpu cpuWithoutCoverage = cpu;
+            cpu.execute(cyclesExpected, memory, coverage);
+            cpuWithoutCoverage.execute(cyclesExpected, memory);
+
+            THEN("The CPU ends up in the same state")
+            {
+                REQUIRE(cpu == cpuWithoutCoverage);
+            }
+        }
+
+        WHEN("The same input is executed twice")
+        {
+            cpu.execute(cyclesExpected, memory, coverage);
+            cpu.resetRegisters(startAddr);
+            coverage.resetEdge();
+            cpu.execute(cyclesExpected, memory, coverage);
+
+            THEN("The edges are counted twice")
+            {
+                REQUIRE(map[EdgeCoverage::location(startAddr)] == 2);
+                REQUIRE(hits(startAddr, startAddr + 1) == 2);
+                REQUIRE(hits(startAddr + 1, startAddr + 2) == 2);
+            }
+        }
+    }
+}
+
+} // namespace c6502
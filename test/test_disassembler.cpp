@@ -0,0 +1,225 @@
+#include "test_c6502.h"
+
+#include "c6502/c6502Disassembler.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace c6502
+{
+static_assert(c_opCodeInfo<Nmos6502>[0xB1].mode == AddrMode::ZeroPageIndirectY, "");
+static_assert(c_opCodeInfo<Nmos6502>[0x6C].length == 3, "");
+static_assert(c_opCodeInfo<Nmos6502>[0xB2].flow == Flow::Invalid, "(zp) is a 65C02 mode");
+static_assert(c_opCodeInfo<Cmos65C02>[0xB2].mnemonic == "LDA", "");
+static_assert(c_opCodeInfo<Nmos6502Undocumented>[0xA7].mnemonic == "LAX", "");
+
+namespace
+{
+std::string formatted(const Instruction& instruction)
+{
+    char buffer[c_formatBufferSize];
+    const int length = format(instruction, buffer, sizeof(buffer));
+    REQUIRE(length > 0);
+    REQUIRE(static_cast<std::size_t>(length) < sizeof(buffer));
+    return buffer;
+}
+
+/// Every opcode the CPU executes is known to the disassembler, with the length it executes
+template <typename TestCpu>
+void requireMetadataMatchesCpu()
+{
+    for (unsigned opCode = 0; opCode < 256; ++opCode)
+    {
+        if (!TestCpu::isValidOpCode(static_cast<u8>(opCode)))
+        {
+            continue;
+        }
+
+        const OpCodeInfo& info = c_opCodeInfo<typename TestCpu::VariantType>[opCode];
+        INFO("Opcode " << opCode);
+        REQUIRE(info.flow == Flow::Next);
+        REQUIRE(TestCpu::OpCodeToString(static_cast<u8>(opCode)).substr(0, 3) == info.mnemonic);
+
+        auto memory = std::make_unique<Memory>();
+        memory->initialize();
+        (*memory)[0x1000] = static_cast<u8>(opCode);
+
+        TestCpu cpu;
+        cpu.resetRegisters(0x1000);
+        cpu.execute(1, *memory);
+        REQUIRE(cpu.PC == 0x1000 + info.length);
+    }
+}
+} // namespace
+
+TEST_CASE("Opcode metadata matches the CPU")
+{
+    std::cout.setstate(std::ios_base::badbit);
+    requireMetadataMatchesCpu<Cpu>();
+    requireMetadataMatchesCpu<CpuUndocumented>();
+    requireMetadataMatchesCpu<Cpu65C02>();
+    requireMetadataMatchesCpu<Cpu2A03>();
+    std::cout.clear();
+
+    std::size_t documented = 0;
+    for (const OpCodeInfo& info : c_opCodeInfo<Nmos6502>)
+    {
+        documented += info.flow != Flow::Invalid;
+    }
+    REQUIRE(documented == 151);
+}
+
+TEST_CASE_METHOD(CpuFixture, "Decode and format instructions")
+{
+    GIVEN("One instruction of every addressing mode")
+    {
+        const u8 program[] = {
+            0xEA,             // NOP
+            0x0A,             // ASL A
+            0xA9, 0x12,       // LDA #$12
+            0xA5, 0x12,       // LDA $12
+            0xB5, 0x12,       // LDA $12,X
+            0xB6, 0x12,       // LDX $12,Y
+            0xAD, 0x34, 0x12, // LDA $1234
+            0xBD, 0x34, 0x12, // LDA $1234,X
+            0xB9, 0x34, 0x12, // LDA $1234,Y
+            0xA1, 0x12,       // LDA ($12,X)
+            0xB1, 0x12,       // LDA ($12),Y
+            0xD0, 0xFE,       // BNE to itself
+            0x6C, 0x34, 0x12, // JMP ($1234)
+            0xFF,             // Invalid
+        };
+        std::copy(std::begin(program), std::end(program), &memory[startAddr]);
+
+        WHEN("Decoded one after the other")
+        {
+            Decoder<Nmos6502> decoder(memory, startAddr);
+            std::vector<std::string> lines;
+            std::vector<u8> lengths;
+            while (decoder.address() < startAddr + sizeof(program))
+            {
+                const Instruction instruction = decoder.next();
+                lines.push_back(formatted(instruction));
+                lengths.push_back(instruction.info.length);
+            }
+
+            THEN("Every instruction is read with its operand and written as assembly")
+            {
+                const std::vector<std::string> expected = {
+                    "NOP",
+                    "ASL A",
+                    "LDA #$12",
+                    "LDA $12",
+                    "LDA $12,X",
+                    "LDX $12,Y",
+                    "LDA $1234",
+                    "LDA $1234,X",
+                    "LDA $1234,Y",
+                    "LDA ($12,X)",
+                    "LDA ($12),Y",
+                    "BNE $1017",
+                    "JMP ($1234)",
+                    ".byte $FF",
+                };
+                REQUIRE(lines == expected);
+                REQUIRE(lengths == std::vector<u8>{1, 1, 2, 2, 2, 2, 3, 3, 3, 2, 2, 2, 3, 1});
+            }
+        }
+
+        WHEN("Decoded by the 65C02")
+        {
+            memory[startAddr] = 0x7C;
+            memory[startAddr + 1] = 0x34;
+            memory[startAddr + 2] = 0x12;
+
+            THEN("Its own opcodes are known")
+            {
+                REQUIRE(formatted(decode<Cmos65C02>(memory, startAddr)) == "JMP ($1234,X)");
+                REQUIRE(formatted(decode<Nmos6502>(memory, startAddr)) == ".byte $7C");
+            }
+        }
+    }
+}
+
+TEST_CASE_METHOD(CpuFixture, "Recursive disassembly from the vectors")
+{
+    GIVEN("A program reached from the reset vector with a subroutine, a branch and data")
+    {
+        const u8 program[] = {
+            0x20, 0x0A, 0x10, // $1000 JSR $100A
+            0xD0, 0x01,       // $1003 BNE $1006
+            0x40,             // $1005 RTI, the IRQ and NMI handler
+            0x4C, 0x00, 0x10, // $1006 JMP $1000
+            0xFF,             // $1009 Data
+            0xA9, 0x01,       // $100A LDA #$01
+            0x60,             // $100C RTS
+            0x12, 0x34,       // $100D Data
+        };
+        std::copy(std::begin(program), std::end(program), &memory[startAddr]);
+        memory[CpuState::c_reset_vector] = 0x00;
+        memory[CpuState::c_reset_vector + 1] = 0x10;
+        memory[CpuState::c_nmi_vector] = 0x05;
+        memory[CpuState::c_nmi_vector + 1] = 0x10;
+        memory[CpuState::c_irq_vector] = 0x05;
+        memory[CpuState::c_irq_vector + 1] = 0x10;
+
+        WHEN("Traced")
+        {
+            auto map = std::make_unique<CodeMap<Nmos6502>>();
+            map->addVectors(memory);
+            map->trace(memory);
+
+            THEN("Exactly the instructions reachable are code")
+            {
+                std::vector<u16> starts;
+                map->forEachInstruction(memory, [&starts](const Instruction& instruction) {
+                    starts.push_back(instruction.address);
+                });
+                const std::vector<u16> expected = {0x1000, 0x1003, 0x1005, 0x1006, 0x100A, 0x100C};
+                REQUIRE(starts == expected);
+                REQUIRE(map->instructionCount() == 6);
+
+                REQUIRE(map->isCode(0x1002));
+                REQUIRE_FALSE(map->isInstructionStart(0x1002));
+                REQUIRE_FALSE(map->isCode(0x1009));
+                REQUIRE_FALSE(map->isCode(0x100D));
+                REQUIRE_FALSE(map->isCode(0x100E));
+            }
+        }
+    }
+
+    GIVEN("A jump through a pointer on a page boundary")
+    {
+        memory[startAddr] = 0x6C;
+        memory[startAddr + 1] = 0xFF;
+        memory[startAddr + 2] = 0x20;
+        memory[0x20FF] = 0x00;
+        memory[0x2000] = 0x30;
+        memory[0x2100] = 0x40;
+        memory[0x3000] = 0xEA;
+        memory[0x4000] = 0xEA;
+
+        WHEN("Traced for the NMOS 6502 and the 65C02")
+        {
+            auto nmos = std::make_unique<CodeMap<Nmos6502>>();
+            nmos->addEntry(startAddr);
+            nmos->trace(memory);
+
+            auto cmos = std::make_unique<CodeMap<Cmos65C02>>();
+            cmos->addEntry(startAddr);
+            cmos->trace(memory);
+
+            THEN("The NMOS 6502 reads the high byte from the start of the same page")
+            {
+                REQUIRE(nmos->isInstructionStart(0x3000));
+                REQUIRE_FALSE(nmos->isInstructionStart(0x4000));
+                REQUIRE(cmos->isInstructionStart(0x4000));
+                REQUIRE_FALSE(cmos->isInstructionStart(0x3000));
+            }
+        }
+    }
+}
+
+} // namespace c6502
@@ -0,0 +1,107 @@
+#include "test_c6502.h"
+
+#include <iostream>
+
+namespace c6502
+{
+/// Runs the program at startAddr fused and unfused with every budget below maxBudget
+template <typename CpuType>
+void requireFusedRunsLikePlain(const Memory& memory, const s32 maxBudget)
+{
+    for (s32 budget = 0; budget < maxBudget; ++budget)
+    {
+        CpuType fused;
+        fused.resetRegisters(CpuFixture::startAddr);
+        Memory fusedMemory = memory;
+        const StopStatus fusedStatus = fused.runFused(budget, fusedMemory);
+
+        CpuType plain;
+        plain.resetRegisters(CpuFixture::startAddr);
+        Memory plainMemory = memory;
+        const StopStatus plainStatus = plain.run(budget, plainMemory);
+
+        INFO("Budget " << budget);
+        REQUIRE(static_cast<const CpuState&>(fused) == static_cast<const CpuState&>(plain));
+        REQUIRE(fusedMemory == plainMemory);
+        REQUIRE(fusedStatus.reason == plainStatus.reason);
+        REQUIRE(fusedStatus.PC == plainStatus.PC);
+        REQUIRE(fusedStatus.cycles == plainStatus.cycles);
+        REQUIRE(fusedStatus.instructions == plainStatus.instructions);
+    }
+}
+
+TEST_CASE_METHOD(CpuFixture, "Superinstructions")
+{
+    GIVEN("Every fused pair, each followed by an instruction that isn't fused")
+    {
+        const u8 program[] = {
+            Cpu::OP::LDA_IM,  0x80,       // 16 bit constant
+            Cpu::OP::LDX_IM,  0x00,       //
+            Cpu::OP::LDA_ZP,  0x10,       // 16 bit from zero page
+            Cpu::OP::LDX_ZP,  0x11,       //
+            Cpu::OP::LDA_ABS, 0x34, 0x12, // 16 bit absolute
+            Cpu::OP::LDX_ABS, 0x35, 0x12, //
+            Cpu::OP::LDA_IM,  0x42,       // Set a zero page variable
+            Cpu::OP::STA_ZP,  0x20,       //
+            Cpu::OP::LDA_IM,  0x43,       // Set an absolute variable
+            Cpu::OP::STA_ABS, 0x00, 0x30, //
+            Cpu::OP::LDA_ZP,  0x20,       // Copy in the zero page
+            Cpu::OP::STA_ZP,  0x21,       //
+            Cpu::OP::LDA_ABS, 0x00, 0x30, // Copy an absolute variable
+            Cpu::OP::STA_ABS, 0x01, 0x30, //
+            Cpu::OP::LDX_IM,  0x44,       // Set with X
+            Cpu::OP::STX_ZP,  0x22,       //
+            Cpu::OP::LDX_ZP,  0x22,       // Copy with X
+            Cpu::OP::STX_ZP,  0x23,       //
+            Cpu::OP::LDX_IM,  0xFF,       // Stack setup
+            Cpu::OP::TXS,                 //
+            Cpu::OP::NOP,                 // Padding
+            Cpu::OP::NOP,                 //
+            Cpu::OP::LDY_IM,  0x01,       // Not fused
+            0xFF,                         // Invalid
+        };
+        std::copy(std::begin(program), std::end(program), &memory[startAddr]);
+        memory[0x0010] = 0x01;
+        memory[0x0011] = 0x80;
+        memory[0x1234] = 0x00;
+        memory[0x1235] = 0x7F;
+
+        WHEN("Run fused and unfused with every budget up to the invalid opcode")
+        {
+            THEN("Both stop in the same state after the same cycles and instructions")
+            {
+                std::cout.setstate(std::ios_base::badbit);
+                requireFusedRunsLikePlain<Cpu>(memory, 70);
+                requireFusedRunsLikePlain<FastCpu>(memory, 70);
+                std::cout.clear();
+            }
+        }
+
+        WHEN("Run fused to the invalid opcode")
+        {
+            Cpu fused;
+            fused.resetRegisters(startAddr);
+            const StopStatus status = fused.runFused(1000, memory);
+
+            THEN("Every instruction is counted with its own cycles")
+            {
+                REQUIRE(status.reason == StopReason::InvalidOpCode);
+                REQUIRE(status.instructions == 23);
+                REQUIRE(status.cycles == 2 + 2 + 3 + 3 + 4 + 4 + 2 + 3 + 2 + 4 + 3 + 3 + 4 + 4 +
+                                             2 + 3 + 3 + 3 + 2 + 2 + 2 + 2 + 2 + 1);
+                REQUIRE(fused.A == 0x43);
+                REQUIRE(fused.X == 0xFF);
+                REQUIRE(fused.Y == 0x01);
+                REQUIRE(fused.SP == 0xFF);
+                REQUIRE(memory[0x0020] == 0x42);
+                REQUIRE(memory[0x0021] == 0x42);
+                REQUIRE(memory[0x3000] == 0x43);
+                REQUIRE(memory[0x3001] == 0x43);
+                REQUIRE(memory[0x0022] == 0x44);
+                REQUIRE(memory[0x0023] == 0x44);
+            }
+        }
+    }
+}
+
+} // namespace c6502
@@ -0,0 +1,108 @@
+#include "test_c6502.h"
+
+#include <utility>
+#include <vector>
+
+namespace c6502
+{
+static_assert(sizeof(Cpu) == sizeof(CpuState) + 2 * sizeof(u64), "NoHooks must not add to the CPU");
+
+/// Records everything the hooks get to see
+struct TraceHooks : public NoHooks
+{
+    void preInstruction(const CpuState& /*cpu*/, const u16 address, const u8 opCode)
+    {
+        instructions.emplace_back(address, opCode);
+    }
+
+    void postInstruction(const CpuState& cpu, const u16 /*address*/, const u8 /*opCode*/)
+    {
+        accumulators.push_back(cpu.A);
+    }
+
+    void onRead(const u16 address, const u8 value)
+    {
+        reads.emplace_back(address, value);
+    }
+
+    void onWrite(const u16 address, const u8 value)
+    {
+        writes.emplace_back(address, value);
+    }
+
+    std::vector<std::pair<u16, u8>> instructions;
+    std::vector<u8> accumulators;
+    std::vector<std::pair<u16, u8>> reads;
+    std::vector<std::pair<u16, u8>> writes;
+};
+
+using TracedCpu = BasicCpu<Nmos6502, TraceHooks>;
+
+class CpuFixtureHooks : public CpuFixture
+{
+public:
+    CpuFixtureHooks()
+    {
+        tracedCpu.resetRegisters(startAddr);
+    }
+
+    TracedCpu tracedCpu;
+};
+
+TEST_CASE_METHOD(CpuFixtureHooks, "Instruction and memory hooks")
+{
+    GIVEN("LDA_ABS followed by NOP")
+    {
+        memory[startAddr] = Cpu::OP::LDA_ABS;
+        memory[startAddr + 1] = 0x34;
+        memory[startAddr + 2] = 0x12;
+        memory[startAddr + 3] = Cpu::OP::NOP;
+        memory[0x1234] = 0x42;
+
+        const s32 cyclesExpected = 6;
+
+        WHEN("Executed by a CPU with hooks")
+        {
+            const s32 cyclesUsed = tracedCpu.execute(cyclesExpected, memory);
+
+            THEN("Every instruction and read is reported in order")
+            {
+                using Access = std::pair<u16, u8>;
+
+                REQUIRE(cyclesUsed == cyclesExpected);
+                REQUIRE(tracedCpu.instructions ==
+                        std::vector<Access>{{startAddr, Cpu::OP::LDA_ABS},
+                                            {startAddr + 3, Cpu::OP::NOP}});
+                REQUIRE(tracedCpu.accumulators == std::vector<u8>{0x42, 0x42});
+                REQUIRE(tracedCpu.reads == std::vector<Access>{{startAddr, Cpu::OP::LDA_ABS},
+                                                               {startAddr + 1, 0x34},
+                                                               {startAddr + 2, 0x12},
+                                                               {0x1234, 0x42},
+                                                               {startAddr + 3, Cpu::OP::NOP},
+                                                               {startAddr + 4, 0x00}});
+                REQUIRE(tracedCpu.writes.empty());
+            }
+
+            THEN("The CPU ends up like one without hooks")
+            {
+                cpu.execute(cyclesExpected, memory);
+                REQUIRE(tracedCpu == cpu);
+            }
+        }
+    }
+
+    GIVEN("A byte written to memory")
+    {
+        const u64 cycles = tracedCpu.cycles();
+        tracedCpu.writeByte(0x0200, 0x99, memory);
+
+        THEN("The write is reported and lands in memory")
+        {
+            REQUIRE(tracedCpu.cycles() == cycles + 1);
+            REQUIRE(memory[0x0200] == 0x99);
+            REQUIRE(tracedCpu.writes == std::vector<std::pair<u16, u8>>{{0x0200, 0x99}});
+        }
+    }
+}
+
+} // namespace c6502
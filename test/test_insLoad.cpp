@@ -32,7 +32,7 @@ public:
 
             takeSnapshot();
 
-            WHEN(Cpu::OpCodeToString(opCode) + " is executed")
+            WHEN(std::string(Cpu::OpCodeToString(opCode)) + " is executed")
             {
                 const s32 cyclesUsed = cpu.execute(cyclesExpected, memory);
 
@@ -64,7 +64,7 @@ public:
 
             takeSnapshot();
 
-            WHEN(Cpu::OpCodeToString(opCode) + " is executed")
+            WHEN(std::string(Cpu::OpCodeToString(opCode)) + " is executed")
             {
                 const s32 cyclesUsed = cpu.execute(cyclesExpected, memory);
 
@@ -100,7 +100,7 @@ public:
 
             takeSnapshot();
 
-            WHEN(Cpu::OpCodeToString(opCode) + " is executed")
+            WHEN(std::string(Cpu::OpCodeToString(opCode)) + " is executed")
             {
                 const s32 cyclesUsed = cpu.execute(cyclesExpected, memory);
 
@@ -133,7 +133,7 @@ public:
 
             takeSnapshot();
 
-            WHEN(Cpu::OpCodeToString(opCode) + " is executed")
+            WHEN(std::string(Cpu::OpCodeToString(opCode)) + " is executed")
             {
                 const s32 cyclesUsed = cpu.execute(cyclesExpected, memory);
 
@@ -170,7 +170,7 @@ public:
 
             takeSnapshot();
 
-            WHEN(Cpu::OpCodeToString(opCode) + " is executed")
+            WHEN(std::string(Cpu::OpCodeToString(opCode)) + " is executed")
             {
                 const s32 cyclesUsed = cpu.execute(cyclesExpected, memory);
 
@@ -203,7 +203,7 @@ public:
             memory[0x1000] = opCode;
             memory[0x1001] = ZPAddr & 0x00FF;
             memory[indirectAddr] = effectiveAddr & 0x00FF;
-            memory[indirectAddr + 1] = effectiveAddr >> 8;
+            memory[(indirectAddr + 1) & 0x00FF] = effectiveAddr >> 8; // The pointer wraps too
             memory[effectiveAddr] = data;
 
             const s32 PCIncrementsExpected = 2;
@@ -211,7 +211,7 @@ public:
 
             takeSnapshot();
 
-            WHEN(Cpu::OpCodeToString(opCode) + " is executed")
+            WHEN(std::string(Cpu::OpCodeToString(opCode)) + " is executed")
             {
                 const s32 cyclesUsed = cpu.execute(cyclesExpected, memory);
 
@@ -243,7 +243,7 @@ public:
             memory[0x1000] = opCode;
             memory[0x1001] = ZPAddr;
             memory[ZPAddr] = indirectAddr & 0x00FF;
-            memory[ZPAddr + 1] = indirectAddr >> 8;
+            memory[static_cast<u8>(ZPAddr + 1)] = indirectAddr >> 8; // $FF wraps to $00
             memory[effectiveAddr] = data;
 
             const bool crossedPageBoundary = (effectiveAddr & 0xFF00) != (indirectAddr & 0xFF00);
@@ -253,7 +253,7 @@ public:
 
             takeSnapshot();
 
-            WHEN(Cpu::OpCodeToString(opCode) + " is executed")
+            WHEN(std::string(Cpu::OpCodeToString(opCode)) + " is executed")
             {
                 const s32 cyclesUsed = cpu.execute(cyclesExpected, memory);
 
@@ -0,0 +1,120 @@
+#include "test_c6502.h"
+
+namespace c6502
+{
+/* X is 0x01 and Y 0x20 unless stored, so that indexed modes wrap in the zero page or cross a
+ * page in some cases and not in others: stores take the same cycles either way. The pointer
+ * at $0040 is $2000.
+ */
+class CpuFixtureInsStore : public CpuFixture
+{
+public:
+    CpuFixtureInsStore()
+    {
+        cpu.X = 0x01;
+        cpu.Y = 0x20;
+        memory[0x0040] = 0x00;
+        memory[0x0041] = 0x20;
+    }
+
+    /// Places the instruction at startAddr, runs it and checks that only address changed
+    void testStore(const Cpu::OP opCode,
+                   u8 Cpu::*reg,
+                   const u8 operandLow,
+                   const u8 operandHigh,
+                   const u16 address,
+                   const s32 cyclesExpected)
+    {
+        const u8 data = GENERATE(0x00, 0x42, 0xFF);
+        cpu.*reg = data;
+        cpu.SR = GENERATE(0x00, 0xFF); // A store leaves the flags as they are
+
+        memory[startAddr] = opCode;
+        memory[startAddr + 1] = operandLow;
+        memory[startAddr + 2] = operandHigh;
+        const u16 PCIncrementsExpected = (operandHigh != 0) ? 3 : 2;
+
+        takeSnapshot();
+
+        WHEN(std::string(Cpu::OpCodeToString(opCode)) + " is executed")
+        {
+            const s32 cyclesUsed = cpu.execute(cyclesExpected, memory);
+
+            THEN("The register is written to the address and nothing else changes")
+            {
+                cpuCopy.PC += PCIncrementsExpected;
+                memoryCopy[address] = data;
+
+                REQUIRE(cyclesUsed == cyclesExpected);
+                requireState();
+            }
+        }
+    }
+};
+
+TEST_CASE_METHOD(CpuFixtureInsStore, "STA_ZP")
+{
+    testStore(Cpu::OP::STA_ZP, &Cpu::A, 0x37, 0, 0x0037, 3);
+}
+
+TEST_CASE_METHOD(CpuFixtureInsStore, "STA_ZPX")
+{
+    testStore(Cpu::OP::STA_ZPX, &Cpu::A, 0xFF, 0, 0x0000, 4);
+}
+
+TEST_CASE_METHOD(CpuFixtureInsStore, "STA_ABS")
+{
+    testStore(Cpu::OP::STA_ABS, &Cpu::A, 0x34, 0x12, 0x1234, 4);
+}
+
+TEST_CASE_METHOD(CpuFixtureInsStore, "STA_ABSX")
+{
+    testStore(Cpu::OP::STA_ABSX, &Cpu::A, 0x34, 0x12, 0x1235, 5);
+}
+
+TEST_CASE_METHOD(CpuFixtureInsStore, "STA_ABSY")
+{
+    testStore(Cpu::OP::STA_ABSY, &Cpu::A, 0xF0, 0x12, 0x1310, 5);
+}
+
+TEST_CASE_METHOD(CpuFixtureInsStore, "STA_IND_ZPX")
+{
+    testStore(Cpu::OP::STA_IND_ZPX, &Cpu::A, 0x3F, 0, 0x2000, 6);
+}
+
+TEST_CASE_METHOD(CpuFixtureInsStore, "STA_IND_ZPY")
+{
+    testStore(Cpu::OP::STA_IND_ZPY, &Cpu::A, 0x40, 0, 0x2020, 6);
+}
+
+TEST_CASE_METHOD(CpuFixtureInsStore, "STX_ZP")
+{
+    testStore(Cpu::OP::STX_ZP, &Cpu::X, 0x37, 0, 0x0037, 3);
+}
+
+TEST_CASE_METHOD(CpuFixtureInsStore, "STX_ZPY")
+{
+    testStore(Cpu::OP::STX_ZPY, &Cpu::X, 0xF0, 0, 0x0010, 4);
+}
+
+TEST_CASE_METHOD(CpuFixtureInsStore, "STX_ABS")
+{
+    testStore(Cpu::OP::STX_ABS, &Cpu::X, 0x34, 0x12, 0x1234, 4);
+}
+
+TEST_CASE_METHOD(CpuFixtureInsStore, "STY_ZP")
+{
+    testStore(Cpu::OP::STY_ZP, &Cpu::Y, 0x37, 0, 0x0037, 3);
+}
+
+TEST_CASE_METHOD(CpuFixtureInsStore, "STY_ZPX")
+{
+    testStore(Cpu::OP::STY_ZPX, &Cpu::Y, 0xFF, 0, 0x0000, 4);
+}
+
+TEST_CASE_METHOD(CpuFixtureInsStore, "STY_ABS")
+{
+    testStore(Cpu::OP::STY_ABS, &Cpu::Y, 0x34, 0x12, 0x1234, 4);
+}
+
+} // namespace c6502
@@ -0,0 +1,304 @@
+#include "test_c6502.h"
+
+#include "c6502/c6502Mapper.h"
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace c6502
+{
+namespace
+{
+/// Fills every 16 KB of the ROM with its bank number
+void fillBanks(BankedMemory& memory)
+{
+    for (std::size_t offset = 0; offset < memory.romSize(); offset += 16 * 1024)
+    {
+        std::memset(memory.rom() + offset, static_cast<int>(offset / (16 * 1024)), 16 * 1024);
+    }
+}
+
+/// How the host maps an address of this process, as /proc/self/smaps tells it
+struct HostMapping
+{
+    bool found = false;
+    char permissions[5] = {};   // rwxp, s in place of p for a shared mapping
+    unsigned long inode = 0;    // Of the file mapped, 0 for anonymous memory
+    unsigned long sharedKb = 0; // Resident pages that are mapped more than once
+};
+
+HostMapping hostMapping(const void* address)
+{
+    const unsigned long target = reinterpret_cast<unsigned long>(address);
+    HostMapping mapping;
+    bool inside = false;
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line;
+    while (std::getline(smaps, line))
+    {
+        unsigned long start = 0;
+        unsigned long end = 0;
+        char permissions[5] = {};
+        unsigned long inode = 0;
+        unsigned long kb = 0;
+        if (std::sscanf(line.c_str(),
+                        "%lx-%lx %4s %*s %*s %lu",
+                        &start,
+                        &end,
+                        permissions,
+                        &inode) == 4)
+        {
+            inside = start <= target && target < end;
+            if (inside)
+            {
+                mapping.found = true;
+                std::memcpy(mapping.permissions, permissions, sizeof(permissions));
+                mapping.inode = inode;
+            }
+        }
+        else if (inside && (std::sscanf(line.c_str(), "Shared_Clean: %lu", &kb) == 1 ||
+                            std::sscanf(line.c_str(), "Shared_Dirty: %lu", &kb) == 1))
+        {
+            mapping.sharedKb += kb;
+        }
+    }
+    return mapping;
+}
+} // namespace
+
+TEST_CASE("Banked memory")
+{
+    GIVEN("A 128 KB UxROM image with 2 KB of RAM")
+    {
+        BankedMemory memory(128 * 1024, 2 * 1024, std::make_unique<UxromMapper>());
+        fillBanks(memory);
+
+        THEN("The first bank is at $8000 and the last bank is fixed at $C000")
+        {
+            REQUIRE(memory[0x8000] == 0);
+            REQUIRE(memory[0xBFFF] == 0);
+            REQUIRE(memory[0xC000] == 7);
+            REQUIRE(memory[0xFFFF] == 7);
+        }
+
+        WHEN("A bank is selected by a write to the ROM")
+        {
+            memory.write(0xC123, 5);
+
+            THEN("Only the switchable bank changes and the ROM is left as it was")
+            {
+                REQUIRE(memory[0x8000] == 5);
+                REQUIRE(memory[0xBFFF] == 5);
+                REQUIRE(memory[0xC123] == 7);
+            }
+        }
+
+        WHEN("A bank past the end of the ROM is selected")
+        {
+            memory.write(0x8000, 8 + 3);
+
+            THEN("It wraps around")
+            {
+                REQUIRE(memory[0x8000] == 3);
+            }
+        }
+
+        WHEN("A bank that is not slot aligned is mapped and then an aligned one")
+        {
+            memory.mapRom(0x80, 0x40, 5 * 16 * 1024 + 0x100);
+            const u8 unaligned = memory[0xBFFF];
+            memory.write(0xC000, 2);
+
+            THEN("The page by page mapping is replaced by the whole bank")
+            {
+                REQUIRE(unaligned == 6);
+                REQUIRE(memory[0x8000] == 2);
+                REQUIRE(memory[0xBFFF] == 2);
+                REQUIRE(memory[0xC000] == 7);
+            }
+        }
+
+        WHEN("The RAM is written")
+        {
+            memory.write(0x0001, 0x42);
+
+            THEN("It's mirrored every 2 KB up to $7FFF")
+            {
+                REQUIRE(memory[0x0801] == 0x42);
+                REQUIRE(memory[0x7801] == 0x42);
+                REQUIRE(memory.ram()[1] == 0x42);
+            }
+        }
+
+        WHEN("A page is unmapped")
+        {
+            memory.unmap(0x60, 0x20);
+            memory.write(0x6000, 0x42);
+
+            THEN("It reads zeros and drops writes")
+            {
+                REQUIRE(memory[0x6000] == 0x00);
+                REQUIRE(memory[0x7FFF] == 0x00);
+                REQUIRE(memory.ram()[0] == 0x00);
+            }
+        }
+    }
+
+    GIVEN("A 16 KB NROM image and a 64 KB AxROM image")
+    {
+        BankedMemory nrom(16 * 1024, 8 * 1024, std::make_unique<NromMapper>());
+        BankedMemory axrom(64 * 1024, 8 * 1024, std::make_unique<AxromMapper>());
+        fillBanks(nrom);
+        fillBanks(axrom);
+        nrom.rom()[0x0123] = 0x99;
+
+        THEN("NROM mirrors its ROM in both halves and ignores writes")
+        {
+            nrom.write(0x8123, 0x01);
+            REQUIRE(nrom[0x8123] == 0x99);
+            REQUIRE(nrom[0xC123] == 0x99);
+        }
+
+        THEN("AxROM switches all 32 KB at once")
+        {
+            REQUIRE(axrom[0x8000] == 0);
+            REQUIRE(axrom[0xC000] == 1);
+            axrom.write(0xFFFF, 1);
+            REQUIRE(axrom[0x8000] == 2);
+            REQUIRE(axrom[0xC000] == 3);
+        }
+    }
+}
+
+TEST_CASE("Shared ROM image")
+{
+    GIVEN("A 32 KB ROM image mapped by two machines")
+    {
+        std::vector<u8> bytes(32 * 1024);
+        for (std::size_t i = 0; i < bytes.size(); ++i)
+        {
+            bytes[i] = static_cast<u8>(i / 16 / 1024 + 1);
+        }
+        const RomImage image(bytes.data(), bytes.size());
+        BankedMemory first(image, 2 * 1024, std::make_unique<AxromMapper>());
+        BankedMemory second(image, 2 * 1024, std::make_unique<AxromMapper>());
+
+        THEN("The image is sealed and both read the same pages")
+        {
+            const int seals = fcntl(image.descriptor(), F_GET_SEALS);
+            REQUIRE((seals & F_SEAL_WRITE) != 0);
+            REQUIRE(first.isRomShared());
+            REQUIRE(first.rom() != second.rom());
+            REQUIRE(first[0x8000] == 1);
+            REQUIRE(second[0x8000] == 1);
+            REQUIRE(second[0xC000] == 2);
+
+            // Two private copies would be anonymous, or at least not share a resident page
+            const HostMapping firstRom = hostMapping(first.rom());
+            const HostMapping secondRom = hostMapping(second.rom());
+            REQUIRE(firstRom.found);
+            REQUIRE(secondRom.found);
+            REQUIRE(firstRom.permissions[3] == 's');
+            REQUIRE(secondRom.permissions[3] == 's');
+            REQUIRE(firstRom.inode != 0);
+            REQUIRE(firstRom.inode == secondRom.inode);
+            REQUIRE(firstRom.sharedKb > 0);
+            REQUIRE(hostMapping(first.ram()).permissions[3] == 'p');
+        }
+
+        WHEN("Both write their RAM and ROM")
+        {
+            first.write(0x0010, 0x42);
+            second.write(0x0010, 0x24);
+            first.write(0x8000, 0xEE);
+
+            THEN("The RAM is private and the ROM is left as it was")
+            {
+                REQUIRE(first[0x0010] == 0x42);
+                REQUIRE(second[0x0010] == 0x24);
+                REQUIRE(first[0x8000] == 1);
+                REQUIRE(second[0x8000] == 1);
+            }
+        }
+
+        WHEN("A child process maps the descriptor it inherits")
+        {
+            const pid_t child = fork();
+            if (child == 0)
+            {
+                // No Catch2 in the child, the exit status is the result
+                int result = 1;
+                try
+                {
+                    const RomImage inherited = RomImage::fromDescriptor(image.descriptor());
+                    BankedMemory third(inherited, 0, std::make_unique<NromMapper>());
+                    const HostMapping rom = hostMapping(third.rom());
+                    const bool same = inherited.size() == bytes.size() &&
+                                      std::memcmp(third.rom(), bytes.data(), bytes.size()) == 0;
+                    result = same && third[0xFFFF] == 2 && rom.permissions[3] == 's' ? 0 : 1;
+                }
+                catch (...)
+                {
+                }
+                _exit(result);
+            }
+            int status = 0;
+            const pid_t waited = waitpid(child, &status, 0);
+
+            THEN("It reads the same image")
+            {
+                REQUIRE(child > 0);
+                REQUIRE(waited == child);
+                REQUIRE(WIFEXITED(status));
+                REQUIRE(WEXITSTATUS(status) == 0);
+            }
+        }
+    }
+}
+
+TEST_CASE("CPU on banked memory")
+{
+    GIVEN("A program in the fixed bank that reads the switchable bank")
+    {
+        BankedMemory memory(64 * 1024, 2 * 1024, std::make_unique<UxromMapper>());
+        fillBanks(memory);
+
+        u8* fixedBank = memory.rom() + 3 * 16 * 1024;
+        const u8 program[] = {
+            Cpu::OP::LDA_ABS, 0x00, 0x80, // LDA $8000
+            Cpu::OP::LDX_ABS, 0x00, 0x80, // LDX $8000, after the bank switch
+            0xFF,                         // Invalid
+        };
+        std::copy(std::begin(program), std::end(program), fixedBank);
+
+        WHEN("Run with a bank switch between the two loads")
+        {
+            std::cout.setstate(std::ios_base::badbit);
+            BankedCpu cpu;
+            cpu.resetRegisters(0xC000);
+            cpu.execute(4, memory);
+            cpu.writeByte(0x8000, 2, memory);
+            const StopStatus status = cpu.run(100, memory);
+            std::cout.clear();
+
+            THEN("Each load sees the bank mapped at the time")
+            {
+                REQUIRE(cpu.A == 0);
+                REQUIRE(cpu.X == 2);
+                REQUIRE(status.reason == StopReason::InvalidOpCode);
+                REQUIRE(status.PC == 0xC006);
+            }
+        }
+    }
+}
+
+} // namespace c6502
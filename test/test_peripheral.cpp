@@ -0,0 +1,153 @@
+#include "test_c6502.h"
+
+#include "c6502/c6502Peripheral.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace c6502
+{
+namespace
+{
+Device timer(Scheduler& scheduler, const u16 address, const u64 period)
+{
+    while (true)
+    {
+        co_await scheduler.cycles(period);
+        scheduler.memory()[address]++;
+    }
+}
+
+Device recorder(Scheduler& scheduler, std::vector<int>& order, const int id, const u64 at)
+{
+    co_await scheduler.cycles(at);
+    order.push_back(id);
+}
+
+/// Records which device ran at which cycle
+using Events = std::vector<std::pair<int, u64>>;
+
+Device timerEvent(Scheduler& scheduler, Events& events, const u64 at)
+{
+    co_await scheduler.cycles(at);
+    events.push_back({1, scheduler.now()});
+}
+
+Device accessEvent(Scheduler& scheduler, Events& events, const u16 address)
+{
+    co_await scheduler.access(address);
+    events.push_back({2, scheduler.now()});
+}
+
+Device watcher(Scheduler& scheduler, std::vector<BusAccess>& seen, std::vector<u64>& when)
+{
+    while (true)
+    {
+        const BusAccess access = co_await scheduler.access(0xD010, 0xD01F);
+        seen.push_back(access);
+        when.push_back(scheduler.now());
+    }
+}
+} // namespace
+
+TEST_CASE_METHOD(CpuFixture, "Coroutine peripherals")
+{
+    Scheduler scheduler(memory);
+    scheduler.cpu().resetRegisters(startAddr);
+
+    GIVEN("A program of NOPs and a timer")
+    {
+        std::fill_n(&memory[startAddr], 0x100, Cpu::OP::NOP);
+        scheduler.add(timer(scheduler, 0xD000, 10));
+
+        WHEN("Run for 100 cycles")
+        {
+            const StopStatus status = scheduler.run(100);
+
+            THEN("The timer fired every 10 cycles")
+            {
+                REQUIRE(status.reason == StopReason::CyclesExhausted);
+                REQUIRE(status.cycles == 100);
+                REQUIRE(status.instructions == 50);
+                REQUIRE(scheduler.now() == 100);
+                REQUIRE(memory[0xD000] == 10);
+                REQUIRE(scheduler.cpu().PC == startAddr + 50);
+            }
+        }
+
+        WHEN("Devices are due in the same cycle")
+        {
+            std::vector<int> order;
+            scheduler.add(recorder(scheduler, order, 1, 20));
+            scheduler.add(recorder(scheduler, order, 2, 10));
+            scheduler.add(recorder(scheduler, order, 3, 20));
+            scheduler.run(30);
+
+            THEN("They are resumed in cycle order, then in the order they started waiting")
+            {
+                REQUIRE(order == std::vector<int>{2, 1, 3});
+            }
+        }
+    }
+
+    GIVEN("A device watching reads of $D010-$D01F")
+    {
+        memory[startAddr] = Cpu::OP::NOP;
+        memory[startAddr + 1] = Cpu::OP::LDA_ABS;
+        memory[startAddr + 2] = 0x14;
+        memory[startAddr + 3] = 0xD0;
+        memory[startAddr + 4] = Cpu::OP::LDA_ABS;
+        memory[startAddr + 5] = 0x00;
+        memory[startAddr + 6] = 0xD0;
+        memory[startAddr + 7] = 0xFF;
+        memory[0xD014] = 0x99;
+
+        std::vector<BusAccess> seen;
+        std::vector<u64> when;
+        scheduler.add(watcher(scheduler, seen, when));
+
+        WHEN("The program runs into the invalid opcode")
+        {
+            const StopStatus status = scheduler.run(1000);
+
+            THEN("The device saw the read at the end of the instruction")
+            {
+                REQUIRE(status.reason == StopReason::InvalidOpCode);
+                REQUIRE(status.PC == startAddr + 7);
+                REQUIRE(seen.size() == 1);
+                REQUIRE(seen[0].address == 0xD014);
+                REQUIRE(seen[0].value == 0x99);
+                REQUIRE_FALSE(seen[0].write);
+                REQUIRE(when == std::vector<u64>{6});
+                REQUIRE(seen[0].cycle == 6);
+                REQUIRE(scheduler.cpu().A == 0x00);
+                REQUIRE(status.cycles == 2 + 4 + 4 + 1);
+                REQUIRE(status.instructions == 3);
+            }
+        }
+    }
+
+    GIVEN("A timer due within an instruction that makes a watched access later on")
+    {
+        memory[startAddr] = Cpu::OP::LDA_ABS;
+        memory[startAddr + 1] = 0x14;
+        memory[startAddr + 2] = 0xD0;
+
+        Events events;
+        scheduler.add(accessEvent(scheduler, events, 0xD014));
+        scheduler.add(timerEvent(scheduler, events, 2));
+
+        WHEN("Run through the instruction")
+        {
+            scheduler.run(4);
+
+            THEN("The timer runs first, and each device sees the cycle it was due at")
+            {
+                REQUIRE(events == Events{{1, 2}, {2, 4}});
+            }
+        }
+    }
+}
+
+} // namespace c6502
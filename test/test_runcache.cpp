@@ -0,0 +1,198 @@
+#include "test_c6502.h"
+
+#include "c6502/c6502RunCache.h"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace c6502
+{
+namespace
+{
+/// A directory of its own for every test, removed with it
+struct TemporaryDirectory
+{
+    TemporaryDirectory()
+        : path(std::filesystem::temp_directory_path() /
+               ("c6502-runcache-" + std::to_string(getpid())))
+    {
+        std::filesystem::remove_all(path);
+    }
+
+    ~TemporaryDirectory()
+    {
+        std::filesystem::remove_all(path);
+    }
+
+    std::filesystem::path path;
+};
+} // namespace
+
+TEST_CASE("Memory hash")
+{
+    GIVEN("The hash of a memory")
+    {
+        Memory memory;
+        memory.initialize();
+        MemoryHash hash(memory);
+        const Hash128 before = hash.combined();
+
+        WHEN("A byte is written and its page rehashed")
+        {
+            memory[0x1234] = 0x42;
+            hash.update(memory, 0x12);
+
+            THEN("It's the hash of the new memory, and another one than before")
+            {
+                REQUIRE(hash.combined() == MemoryHash(memory).combined());
+                REQUIRE(!(hash.combined() == before));
+                REQUIRE(hash.page(0x13) == hash.page(0x11));
+            }
+        }
+
+        WHEN("The same byte is written to another page")
+        {
+            Memory other = memory;
+            memory[0x1234] = 0x42;
+            other[0x1334] = 0x42;
+
+            THEN("The hashes differ")
+            {
+                REQUIRE(!(MemoryHash(memory).combined() == MemoryHash(other).combined()));
+            }
+        }
+    }
+}
+
+TEST_CASE_METHOD(CpuFixture, "Run cache")
+{
+    GIVEN("A program that ends at an invalid opcode")
+    {
+        const u8 program[] = {
+            Cpu::OP::LDA_IM, 0x42, //
+            Cpu::OP::LDX_IM, 0x80, //
+            Cpu::OP::TXS,          //
+            Cpu::OP::NOP,          //
+            0xFF,                  // Invalid
+        };
+        std::copy(std::begin(program), std::end(program), &memory[startAddr]);
+        std::cout.setstate(std::ios_base::badbit);
+
+        RunCache cache(1024 * 1024);
+        const Cpu initial = cpu;
+
+        Cpu executed = initial;
+        const StopStatus expected = executed.run(100, memory);
+
+        WHEN("The same run is made twice")
+        {
+            Cpu first = initial;
+            const StopStatus firstStatus = cache.run(first, 100, memory);
+            Cpu second = initial;
+            second.run(2, memory); // A clock ahead doesn't matter
+            second.resetRegisters(startAddr);
+            const StopStatus secondStatus = cache.run(second, 100, memory);
+
+            THEN("The second comes from the cache with the same outcome")
+            {
+                REQUIRE(cache.stats().misses == 1);
+                REQUIRE(cache.stats().hits == 1);
+                REQUIRE(firstStatus == expected);
+                REQUIRE(secondStatus == expected);
+                REQUIRE(static_cast<const CpuState&>(first) == executed);
+                REQUIRE(static_cast<const CpuState&>(second) == executed);
+                REQUIRE(second.cycles() == 2 + expected.cycles);
+            }
+        }
+
+        WHEN("Runs differ in budget, registers, memory or variant")
+        {
+            Cpu cpus[4] = {initial, initial, initial, initial};
+            cpus[2].Y = 1;
+            cache.run(cpus[0], 100, memory);
+            cache.run(cpus[1], 5, memory);
+            cache.run(cpus[2], 100, memory);
+            memory[0x2000] = 1;
+            cache.run(cpus[3], 100, memory);
+            Cpu65C02 cmos;
+            cmos.resetRegisters(startAddr);
+            cache.run(cmos, 100, memory);
+
+            THEN("None of them is a hit")
+            {
+                REQUIRE(cache.stats().misses == 5);
+                REQUIRE(cache.stats().hits == 0);
+                REQUIRE(cpus[1].PC == startAddr + 5); // After the TXS that crosses the budget
+            }
+        }
+
+        WHEN("The capacity holds a single result")
+        {
+            RunCache small(1);
+            Cpu a = initial;
+            Cpu b = initial;
+            small.run(a, 100, memory);
+            small.run(b, 5, memory);
+            a = initial;
+            small.run(a, 100, memory);
+
+            THEN("The least recently used result is evicted")
+            {
+                REQUIRE(small.stats().misses == 3);
+                REQUIRE(small.stats().evictions == 2);
+            }
+        }
+
+        WHEN("Results are kept in a directory")
+        {
+            const TemporaryDirectory directory;
+            {
+                RunCache writer(1024 * 1024, directory.path);
+                Cpu a = initial;
+                writer.run(a, 100, memory);
+            }
+            RunCache reader(1024 * 1024, directory.path);
+            Cpu b = initial;
+            const StopStatus status = reader.run(b, 100, memory);
+
+            THEN("Another cache reads them from there")
+            {
+                REQUIRE(reader.stats().diskHits == 1);
+                REQUIRE(reader.stats().misses == 0);
+                REQUIRE(status == expected);
+                REQUIRE(static_cast<const CpuState&>(b) == executed);
+            }
+
+            THEN("The file holds the fields one after another, no padding")
+            {
+                // Magic, version, status, registers and the page count, the run changes no page
+                const std::uintmax_t size = 8 + 4 + (1 + 1 + 2 + 8 + 8) + (2 + 5 * 1) + 4;
+                for (const auto& file : std::filesystem::directory_iterator(directory.path))
+                {
+                    REQUIRE(file.file_size() == size);
+                }
+            }
+
+            THEN("A damaged file is a miss")
+            {
+                for (const auto& file : std::filesystem::directory_iterator(directory.path))
+                {
+                    std::ofstream(file.path(), std::ios::binary | std::ios::trunc) << "c6502";
+                }
+                RunCache damaged(1024 * 1024, directory.path);
+                Cpu c = initial;
+                REQUIRE(damaged.run(c, 100, memory) == expected);
+                REQUIRE(damaged.stats().diskHits == 0);
+                REQUIRE(damaged.stats().misses == 1);
+            }
+        }
+
+        std::cout.clear();
+    }
+}
+
+} // namespace c6502
@@ -0,0 +1,142 @@
+#include "test_c6502.h"
+
+#include "c6502/c6502Stats.h"
+#include "c6502/c6502System.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <thread>
+
+namespace c6502
+{
+namespace
+{
+/// Looks at the stats after every instruction, as a monitor on another thread would
+struct StatsWatcher : public NoHooks
+{
+    void postInstruction(const CpuState& /*cpu*/, const u16 /*address*/, const u8 /*opCode*/)
+    {
+        seenCycles = std::max(seenCycles, stats->snapshot().cycles);
+    }
+
+    const Stats* stats = nullptr;
+    u64 seenCycles = 0;
+};
+} // namespace
+
+TEST_CASE_METHOD(CpuFixture, "Runtime statistics")
+{
+    GIVEN("LDA_ABS, NOP and an invalid opcode")
+    {
+        memory[startAddr] = Cpu::OP::LDA_ABS;
+        memory[startAddr + 1] = 0x34;
+        memory[startAddr + 2] = 0x12;
+        memory[startAddr + 3] = Cpu::OP::NOP;
+        memory[startAddr + 4] = 0xFF;
+
+        Stats stats;
+
+        WHEN("Run with a budget that ends inside LDA_ABS, then to the invalid opcode")
+        {
+            const StopStatus first = measuredRun(cpu, 3, memory, stats);
+            const StopStatus second = measuredRun(cpu, 100, memory, stats);
+            const StatsSnapshot snapshot = stats.snapshot();
+
+            THEN("Instructions, cycles, overshoot and the stall are all counted")
+            {
+                REQUIRE(first.instructions == 1);
+                REQUIRE(first.cycles == 4);
+                REQUIRE(second.instructions == 1);
+                REQUIRE(second.reason == StopReason::InvalidOpCode);
+
+                REQUIRE(snapshot.instructions == 2);
+                REQUIRE(snapshot.cycles == 4 + 2 + 1);
+                REQUIRE(snapshot.overshootCycles == 1);
+                REQUIRE(snapshot.runs == 2);
+                REQUIRE(snapshot.stalls == 1);
+                REQUIRE(snapshot.emulatedMHz() >= 0.0);
+            }
+        }
+
+        WHEN("A run to a far deadline retires more than 2^32 instructions")
+        {
+            const u64 instructions = (u64{1} << 32) + 5;
+            const StopStatus status{StopReason::CyclesExhausted, 0, 0, 2 * instructions,
+                                    instructions};
+            stats.record(status, 2 * instructions, 0);
+            stats.record(status, 2 * instructions, 0);
+
+            THEN("The count doesn't wrap")
+            {
+                REQUIRE(stats.snapshot().instructions == 2 * instructions);
+            }
+        }
+    }
+
+    GIVEN("A run of four chunks of NOPs")
+    {
+        memory.data.fill(Cpu::OP::NOP);
+        Stats stats;
+        BasicCpu<Nmos6502, StatsWatcher> watchedCpu;
+        watchedCpu.resetRegisters(startAddr);
+        watchedCpu.stats = &stats;
+
+        WHEN("It runs")
+        {
+            std::cout.setstate(std::ios_base::badbit);
+            const StopStatus status =
+                measuredRun(watchedCpu, static_cast<s32>(4 * c_statsChunkCycles), memory, stats);
+            std::cout.clear();
+
+            THEN("The stats grow while it runs and count it as one run at the end")
+            {
+                REQUIRE(status.cycles == 4 * c_statsChunkCycles);
+                REQUIRE(status.instructions == 2 * c_statsChunkCycles);
+                REQUIRE(watchedCpu.seenCycles == 3 * c_statsChunkCycles);
+                REQUIRE(stats.snapshot().cycles == 4 * c_statsChunkCycles);
+                REQUIRE(stats.snapshot().runs == 1);
+                REQUIRE(stats.snapshot().overshootCycles == 0);
+            }
+        }
+    }
+
+    GIVEN("A system of two CPUs running NOPs")
+    {
+        System system(2, 1000);
+        for (std::size_t i = 0; i < system.cpuCount(); ++i)
+        {
+            system.cpu(i).resetRegisters(0x0000);
+            system.memory(i).data.fill(Cpu::OP::NOP);
+        }
+
+        WHEN("The stats are read from another thread while it runs")
+        {
+            std::atomic<bool> done{false};
+            u64 lastCycles = 0;
+            bool monotonic = true;
+            std::thread monitor([&]() {
+                while (!done)
+                {
+                    const u64 cycles = system.stats(1).snapshot().cycles;
+                    monotonic = monotonic && cycles >= lastCycles;
+                    lastCycles = cycles;
+                }
+            });
+
+            system.run(20'000);
+            done = true;
+            monitor.join();
+
+            THEN("The monitor only sees the counters grow and they end up exact")
+            {
+                REQUIRE(monotonic);
+                REQUIRE(system.stats(0).snapshot().cycles == 20'000);
+                REQUIRE(system.stats(1).snapshot().instructions == 10'000);
+                REQUIRE(system.stats(1).snapshot().runs == 20);
+            }
+        }
+    }
+}
+
+} // namespace c6502
@@ -0,0 +1,147 @@
+#include "test_c6502.h"
+
+#include "c6502/c6502System.h"
+
+#include <limits>
+
+namespace c6502
+{
+TEST_CASE("Multi CPU system")
+{
+    static constexpr u16 startAddr = 0x1000;
+    static constexpr u16 sharedAddr = 0x8010;
+
+    GIVEN("Two CPUs sharing page $80")
+    {
+        System system(2, 100);
+        system.sharePage(0x80);
+        for (std::size_t i = 0; i < system.cpuCount(); ++i)
+        {
+            system.cpu(i).resetRegisters(startAddr);
+            system.memory(i)[startAddr] = Cpu::OP::LDA_ABS;
+            system.memory(i)[startAddr + 1] = sharedAddr & 0xFF;
+            system.memory(i)[startAddr + 2] = sharedAddr >> 8;
+        }
+
+        WHEN("The host writes to the shared page")
+        {
+            system.writeShared(sharedAddr, 0x42);
+            system.run(4);
+
+            THEN("Every CPU reads the value")
+            {
+                REQUIRE(system.cpu(0).A == 0x42);
+                REQUIRE(system.cpu(1).A == 0x42);
+            }
+        }
+
+        WHEN("Both CPUs write to the same shared address and one to a private address")
+        {
+            system.cpu(1).writeByte(sharedAddr, 0x22, system.memory(1));
+            system.cpu(0).writeByte(sharedAddr, 0x11, system.memory(0));
+            system.cpu(0).writeByte(0x2000, 0x33, system.memory(0));
+            system.run(4);
+
+            THEN("The shared write of the highest CPU wins and the private one stays private")
+            {
+                REQUIRE(system.isShared(sharedAddr));
+                REQUIRE_FALSE(system.isShared(0x2000));
+                REQUIRE(system.memory(0)[sharedAddr] == 0x22);
+                REQUIRE(system.memory(1)[sharedAddr] == 0x22);
+                REQUIRE(system.memory(0)[0x2000] == 0x33);
+                REQUIRE(system.memory(1)[0x2000] == 0x00);
+            }
+        }
+    }
+
+    GIVEN("A CPU with a quantum near the largest budget")
+    {
+        System system(1, std::numeric_limits<s32>::max() / 2);
+        system.cpu(0).resetRegisters(startAddr);
+        system.memory(0)[startAddr] = 0xFF;
+
+        WHEN("Run for the largest budget")
+        {
+            system.run(std::numeric_limits<s32>::max());
+
+            THEN("The quanta are counted without overflowing and the CPU runs")
+            {
+                REQUIRE(system.isHalted(0));
+                REQUIRE(system.status(0).PC == startAddr);
+            }
+        }
+    }
+
+    GIVEN("Four CPUs running different programs")
+    {
+        auto build = [](const bool parallel) {
+            auto system = std::make_unique<System>(4, 7, parallel);
+            system->sharePage(0x80);
+            for (std::size_t i = 0; i < system->cpuCount(); ++i)
+            {
+                Memory& memory = system->memory(i);
+                system->cpu(i).resetRegisters(startAddr);
+                system->cpu(i).X = static_cast<u8>(i);
+                for (u16 j = 0; j < 0x100; ++j)
+                {
+                    memory[startAddr + 3 * j] = (j + i) % 3 == 0 ? Cpu::OP::LDA_ZPX
+                                                                : Cpu::OP::LDY_IM;
+                    memory[startAddr + 3 * j + 1] = static_cast<u8>(j * 7 + i);
+                    memory[startAddr + 3 * j + 2] = Cpu::OP::NOP;
+                    memory[j] = static_cast<u8>(j ^ i);
+                }
+                // Every CPU stores to the shared page, partly to the same addresses, and
+                // reads back what the others stored
+                for (u16 j = 0; j < 0x100; j += 8 + static_cast<u16>(i))
+                {
+                    memory[startAddr + 3 * j] = Cpu::OP::STA_ABS;
+                    memory[startAddr + 3 * j + 1] = static_cast<u8>(j % 16);
+                    memory[startAddr + 3 * j + 2] = 0x80;
+                    memory[startAddr + 3 * j + 3] = Cpu::OP::LDA_ABS;
+                    memory[startAddr + 3 * j + 4] = static_cast<u8>((j + 5) % 16);
+                    memory[startAddr + 3 * j + 5] = 0x80;
+                }
+            }
+            // The third CPU runs into an invalid opcode early
+            system->memory(2)[startAddr + 30] = 0xFF;
+            return system;
+        };
+
+        WHEN("Run in parallel and serially")
+        {
+            auto parallel = build(true);
+            auto serial = build(false);
+            parallel->run(500);
+            serial->run(500);
+
+            THEN("The results are the same")
+            {
+                for (std::size_t i = 0; i < parallel->cpuCount(); ++i)
+                {
+                    REQUIRE(parallel->cpu(i) == serial->cpu(i));
+                    REQUIRE(parallel->memory(i) == serial->memory(i));
+                    REQUIRE(parallel->isHalted(i) == serial->isHalted(i));
+                }
+                REQUIRE(parallel->isHalted(2));
+                REQUIRE(parallel->status(2).PC == startAddr + 30);
+                REQUIRE_FALSE(parallel->isHalted(0));
+            }
+
+            THEN("Every CPU sees the stores of all the others")
+            {
+                bool stored = false;
+                for (u16 addr = 0x8000; addr < 0x8010; ++addr)
+                {
+                    stored = stored || parallel->memory(0)[addr] != 0;
+                    for (std::size_t i = 1; i < parallel->cpuCount(); ++i)
+                    {
+                        REQUIRE(parallel->memory(i)[addr] == parallel->memory(0)[addr]);
+                    }
+                }
+                REQUIRE(stored);
+            }
+        }
+    }
+}
+
+} // namespace c6502
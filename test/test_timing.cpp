@@ -0,0 +1,127 @@
+#include "test_c6502.h"
+
+#include <iostream>
+#include <utility>
+#include <vector>
+
+namespace c6502
+{
+static_assert(detail::c_opCodeCycles<Nmos6502>[CpuState::OP::LDA_IND_ZPX] == 6, "");
+static_assert(detail::c_opCodeCycles<Nmos6502>[CpuState::OP::LDA_ABSX] == 4, "");
+static_assert(detail::c_opCodeCycles<Nmos6502>[CpuState::OP::TXS] == 2, "");
+static_assert(detail::c_opCodeCycles<Nmos6502>[0xFF] == 1, "The fetch of an invalid opcode");
+static_assert(detail::c_opCodeCycles<Cmos65C02>[CpuState::OP::LDA_IND_ZP] == 5, "");
+
+namespace
+{
+/// Records the address of every read
+struct BusHooks : public NoHooks
+{
+    void onRead(const u16 address, const u8 /*value*/)
+    {
+        reads.push_back(address);
+    }
+
+    std::vector<u16> reads;
+};
+
+template <typename Timing>
+using BusCpu = BasicCpu<Nmos6502, BusHooks, Timing>;
+} // namespace
+
+TEST_CASE_METHOD(CpuFixture, "Cycle exact and fast timing")
+{
+    GIVEN("Indexed loads that wrap and cross pages, and implied instructions")
+    {
+        const u8 program[] = {
+            Cpu::OP::LDA_ZPX,     0xF0,       // Wraps to $10
+            Cpu::OP::LDA_ABSX,    0xF0, 0x12, // Crosses to $1310
+            Cpu::OP::LDA_IND_ZPX, 0x30,       // Pointer at $50
+            Cpu::OP::LDA_IND_ZPY, 0x60,       // Crosses to $1410
+            Cpu::OP::NOP,                     //
+            Cpu::OP::TXS,                     //
+            0xFF,                             // Invalid
+        };
+        std::copy(std::begin(program), std::end(program), &memory[startAddr]);
+        memory[0x0050] = 0x00;
+        memory[0x0051] = 0x20;
+        memory[0x0060] = 0xF0;
+        memory[0x0061] = 0x13;
+
+        WHEN("Run cycle exact")
+        {
+            BusCpu<CycleExact> cpu;
+            cpu.resetRegisters(startAddr);
+            cpu.X = 0x20;
+            cpu.Y = 0x20;
+            cpu.run(1000, memory);
+
+            THEN("Every cycle is a read, dummy reads at the addresses on the bus included")
+            {
+                const u16 s = startAddr;
+                const std::vector<u16> expected = {
+                    s,      s + 1,  0x00F0, 0x0010,                 // LDA $F0,X
+                    s + 2,  s + 3,  s + 4,  0x1210, 0x1310,         // LDA $12F0,X
+                    s + 5,  s + 6,  0x0030, 0x0050, 0x0051, 0x2000, // LDA ($30,X)
+                    s + 7,  s + 8,  0x0060, 0x0061, 0x1310, 0x1410, // LDA ($60),Y
+                    s + 9,  s + 10,                                 // NOP
+                    s + 10, s + 11,                                 // TXS
+                    s + 11,                                         // Invalid
+                };
+                REQUIRE(cpu.reads == expected);
+                REQUIRE(cpu.cycles() == expected.size());
+            }
+        }
+
+        WHEN("Run fast and cycle exact with every budget up to the invalid opcode")
+        {
+            THEN("Both stop in the same state after the same cycles, the fast one reads less")
+            {
+                std::cout.setstate(std::ios_base::badbit);
+                for (s32 budget = 0; budget < 30; ++budget)
+                {
+                    BusCpu<Fast> fast;
+                    fast.resetRegisters(startAddr);
+                    fast.X = fast.Y = 0x20;
+                    const StopStatus fastStatus = fast.run(budget, memory);
+
+                    BusCpu<CycleExact> exact;
+                    exact.resetRegisters(startAddr);
+                    exact.X = exact.Y = 0x20;
+                    const StopStatus exactStatus = exact.run(budget, memory);
+
+                    INFO("Budget " << budget);
+                    REQUIRE(fast == exact);
+                    REQUIRE(fast.cycles() == exact.cycles());
+                    REQUIRE(fastStatus.reason == exactStatus.reason);
+                    REQUIRE(fastStatus.cycles == exactStatus.cycles);
+                    REQUIRE(fastStatus.instructions == exactStatus.instructions);
+                    REQUIRE(fast.reads.size() <= exact.reads.size());
+                }
+                std::cout.clear();
+            }
+        }
+
+        WHEN("Run fast with superinstructions")
+        {
+            memory[startAddr + 9] = Cpu::OP::LDX_IM;
+            memory[startAddr + 10] = 0xFF;
+            memory[startAddr + 11] = Cpu::OP::TXS;
+            memory[startAddr + 12] = 0xFF;
+
+            FastCpu fast;
+            fast.resetRegisters(startAddr);
+            fast.X = fast.Y = 0x20;
+            const StopStatus status = fast.runFused(1000, memory);
+
+            THEN("The pair is charged both instructions")
+            {
+                REQUIRE(status.reason == StopReason::InvalidOpCode);
+                REQUIRE(status.cycles == 4 + 5 + 6 + 6 + 2 + 2 + 1);
+                REQUIRE(fast.SP == 0xFF);
+            }
+        }
+    }
+}
+
+} // namespace c6502
@@ -0,0 +1,199 @@
+#include "test_c6502.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace c6502
+{
+static_assert(!Cpu::isValidOpCode(Cpu::OP::LAX_ZP), "LAX is undocumented");
+static_assert(CpuUndocumented::isValidOpCode(Cpu::OP::LAX_ZP), "");
+static_assert(!Cpu::isValidOpCode(Cpu::OP::LDA_IND_ZP), "(zp) is a 65C02 mode");
+static_assert(Cpu65C02::isValidOpCode(Cpu::OP::LDA_IND_ZP), "");
+static_assert(Cpu2A03::OpCodeToString(Cpu::OP::LDA_IM) == "LDA_IM", "");
+static_assert(Cpu65C02::OpCodeToString(Cpu::OP::LDA_IND_ZP) == "LDA_IND_ZP", "");
+static_assert(CpuUndocumented::OpCodeToString(0x1C) == "NOP_ABSX", "");
+static_assert(CpuUndocumented::OpCodeToString(0x1A) == "NOP", "");
+static_assert(!Ricoh2A03::c_decimalMode && Nmos6502::c_decimalMode, "");
+
+class CpuFixtureVariants : public CpuFixture
+{
+public:
+    CpuFixtureVariants()
+    {
+        undocumentedCpu.resetRegisters(startAddr);
+        cmosCpu.resetRegisters(startAddr);
+    }
+
+    CpuUndocumented undocumentedCpu;
+    Cpu65C02 cmosCpu;
+};
+
+TEST_CASE_METHOD(CpuFixtureVariants, "Undocumented opcodes")
+{
+    GIVEN("LAX_ABS")
+    {
+        memory[startAddr] = Cpu::OP::LAX_ABS;
+        memory[startAddr + 1] = 0x34;
+        memory[startAddr + 2] = 0x12;
+        memory[0x1234] = 0x80;
+
+        const s32 cyclesExpected = 4;
+
+        WHEN("Executed by the NMOS CPU")
+        {
+            THEN("It is an invalid opcode")
+            {
+                REQUIRE_THROWS_AS(cpu.execute(cyclesExpected, memory), InvalidOpCode);
+            }
+        }
+
+        WHEN("Executed by the NMOS CPU with undocumented opcodes")
+        {
+            const s32 cyclesUsed = undocumentedCpu.execute(cyclesExpected, memory);
+
+            THEN("Both A and X are loaded")
+            {
+                REQUIRE(cyclesUsed == cyclesExpected);
+                REQUIRE(undocumentedCpu.A == 0x80);
+                REQUIRE(undocumentedCpu.X == 0x80);
+                REQUIRE(undocumentedCpu.N);
+                REQUIRE_FALSE(undocumentedCpu.Z);
+                REQUIRE(undocumentedCpu.PC == startAddr + 3);
+            }
+        }
+    }
+
+    GIVEN("The multi byte NOPs")
+    {
+        const u8 program[] = {0x1A, 0x80, 0x00, 0x04, 0x00, 0x14, 0x00, 0x0C, 0x00, 0x00, 0x1C,
+                              0x00, 0x00};
+        std::copy(std::begin(program), std::end(program), &memory[startAddr]);
+
+        const s32 cyclesExpected = 2 + 2 + 3 + 4 + 4 + 4;
+
+        WHEN("Executed by the NMOS CPU with undocumented opcodes")
+        {
+            takeSnapshot();
+            const s32 cyclesUsed = undocumentedCpu.execute(cyclesExpected, memory);
+
+            THEN("Only the PC moves")
+            {
+                REQUIRE(cyclesUsed == cyclesExpected);
+                REQUIRE(undocumentedCpu.PC == startAddr + sizeof(program));
+                REQUIRE(undocumentedCpu.A == 0);
+                REQUIRE(undocumentedCpu.X == 0);
+                REQUIRE(memory == memoryCopy);
+            }
+        }
+    }
+}
+
+TEST_CASE_METHOD(CpuFixtureVariants, "65C02 opcodes")
+{
+    GIVEN("LDA_IND_ZP")
+    {
+        memory[startAddr] = Cpu::OP::LDA_IND_ZP;
+        memory[startAddr + 1] = 0x40;
+        memory[0x0040] = 0x34;
+        memory[0x0041] = 0x12;
+        memory[0x1234] = 0x37;
+
+        const s32 cyclesExpected = 5;
+
+        WHEN("Executed by the 65C02")
+        {
+            const s32 cyclesUsed = cmosCpu.execute(cyclesExpected, memory);
+
+            THEN("A is loaded through the zero page pointer")
+            {
+                REQUIRE(cyclesUsed == cyclesExpected);
+                REQUIRE(cmosCpu.A == 0x37);
+                REQUIRE(cmosCpu.PC == startAddr + 2);
+            }
+        }
+
+        WHEN("Executed by the NMOS CPU")
+        {
+            THEN("It is an invalid opcode")
+            {
+                REQUIRE_THROWS_AS(cpu.execute(cyclesExpected, memory), InvalidOpCode);
+            }
+        }
+    }
+
+    GIVEN("STA_IND_ZP")
+    {
+        memory[startAddr] = Cpu::OP::STA_IND_ZP;
+        memory[startAddr + 1] = 0x40;
+        memory[0x0040] = 0x34;
+        memory[0x0041] = 0x12;
+        cmosCpu.A = 0x37;
+
+        WHEN("Executed by the 65C02")
+        {
+            const s32 cyclesUsed = cmosCpu.execute(5, memory);
+
+            THEN("A is stored through the zero page pointer")
+            {
+                REQUIRE(cyclesUsed == 5);
+                REQUIRE(memory[0x1234] == 0x37);
+                REQUIRE(cmosCpu.PC == startAddr + 2);
+            }
+        }
+
+        WHEN("Executed by the NMOS CPU")
+        {
+            THEN("It is an invalid opcode")
+            {
+                REQUIRE_THROWS_AS(cpu.execute(5, memory), InvalidOpCode);
+            }
+        }
+    }
+
+    GIVEN("LDA_IND_ZP with the pointer at $FF")
+    {
+        memory[startAddr] = Cpu::OP::LDA_IND_ZP;
+        memory[startAddr + 1] = 0xFF;
+        memory[0x00FF] = 0x34;
+        memory[0x0000] = 0x12;
+        memory[0x0100] = 0x56;
+        memory[0x1234] = 0xAA;
+        memory[0x5634] = 0xBB;
+
+        WHEN("Executed by the 65C02")
+        {
+            cmosCpu.execute(5, memory);
+
+            THEN("The high byte of the pointer wraps to $00")
+            {
+                REQUIRE(cmosCpu.A == 0xAA);
+            }
+        }
+    }
+}
+
+template <typename VariantCpu>
+void requireOpCodeNamesMatchExecution()
+{
+    for (unsigned opCode = 0; opCode <= 0xFF; ++opCode)
+    {
+        VariantCpu variantCpu;
+        Memory memory;
+        memory.initialize();
+        variantCpu.resetRegisters(0x1000);
+
+        const bool executed =
+            variantCpu.tryExecuteInstruction(static_cast<Cpu::OP>(opCode), memory);
+        REQUIRE(executed == VariantCpu::isValidOpCode(static_cast<u8>(opCode)));
+    }
+}
+
+TEST_CASE("Every variant executes exactly the opcodes it names")
+{
+    requireOpCodeNamesMatchExecution<Cpu>();
+    requireOpCodeNamesMatchExecution<CpuUndocumented>();
+    requireOpCodeNamesMatchExecution<Cpu65C02>();
+    requireOpCodeNamesMatchExecution<Cpu2A03>();
+}
+
+} // namespace c6502
@@ -0,0 +1,356 @@
+/* Headless runner for batches of memory images.
+ *
+ * Every image is loaded into its own memory and run until it has used the cycle budget,
+ * traps in an instruction that leaves PC where it was, reaches a breakpoint or hits an
+ * invalid opcode. The final registers and the run statistics of every image are written
+ * as JSON, in the order the images were given. Directories are expanded to the regular
+ * files in them, sorted by name. Images are shared out between the worker threads.
+ *
+ * Usage: c6502-run [options] <image or directory>...
+ *   -l address    load address, default $0000
+ *   -s address    start address, default the load address
+ *   -r            start at the reset vector of the loaded image instead
+ *   -c cycles     cycle budget per image, default 100000000
+ *   -b address    stop before executing the instruction at address, may be repeated
+ *   -j threads    worker threads, default one per core
+ *   -o file       write the JSON to file instead of stdout
+ *
+ * Addresses take any base strtoul understands, e.g. 0x400. The exit code is 0 when every
+ * image could be loaded, 1 otherwise and 2 for bad arguments.
+ */
+
+#include "c6502/c6502.h"
+#include "c6502/c6502Stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace c6502
+{
+namespace run
+{
+using Breakpoints = std::bitset<Memory::MEM_MAX>;
+
+/// Stops the CPU after an instruction that traps or leads to a breakpoint
+struct RunHooks : public NoHooks
+{
+    void postInstruction(const CpuState& cpu, const u16 address, const u8 /*opCode*/)
+    {
+        trapped = cpu.PC == address;
+        atBreakpoint = breakpoints->test(cpu.PC);
+    }
+
+    bool stopRequested() const
+    {
+        return trapped || atBreakpoint;
+    }
+
+    const Breakpoints* breakpoints = nullptr;
+    bool trapped = false;
+    bool atBreakpoint = false;
+};
+
+/// Nothing watches the bus during a batch run, so instructions are timed as a whole
+using RunCpu = BasicCpu<Nmos6502, RunHooks, Fast>;
+
+struct Options
+{
+    u16 loadAddress = 0x0000;
+    u16 startAddress = 0x0000;
+    bool startAddressGiven = false;
+    bool startAtResetVector = false;
+    u64 cycles = 100'000'000;
+    Breakpoints breakpoints;
+    unsigned threadCount = std::max(1u, std::thread::hardware_concurrency());
+    std::string outputPath;
+    std::vector<std::string> images;
+};
+
+struct Result
+{
+    const char* status = "error";
+    std::string error;
+    CpuState cpu{};
+    u8 opCode = 0;
+    StatsSnapshot stats;
+};
+
+Result runImage(const std::string& path, const Options& options)
+{
+    Result result;
+
+    std::ifstream file(path, std::ios::binary);
+    const std::vector<char> image{std::istreambuf_iterator<char>(file),
+                                  std::istreambuf_iterator<char>()};
+    if (!file.is_open() || image.size() > Memory::MEM_MAX - options.loadAddress)
+    {
+        result.error = file.is_open() ? "image doesn't fit in memory" : "can't read image";
+        return result;
+    }
+
+    auto memory = std::make_unique<Memory>();
+    memory->initialize();
+    std::copy(image.begin(), image.end(), &(*memory)[options.loadAddress]);
+
+    RunCpu cpu;
+    cpu.breakpoints = &options.breakpoints;
+    if (options.startAtResetVector)
+    {
+        cpu.resetRegisters((*memory)[CpuState::c_reset_vector] |
+                           ((*memory)[CpuState::c_reset_vector + 1] << 8));
+    }
+    else
+    {
+        cpu.resetRegisters(options.startAddressGiven ? options.startAddress
+                                                     : options.loadAddress);
+    }
+
+    // The hooks see where each instruction leads, a breakpoint at the start is checked here
+    Stats stats;
+    cpu.atBreakpoint = options.breakpoints.test(cpu.PC);
+    StopStatus status{StopReason::HookRequested, 0, cpu.PC, 0, 0};
+    if (!cpu.atBreakpoint)
+    {
+        status = measuredRunUntil(cpu, options.cycles, *memory, stats);
+    }
+    result.status = "cycles_exhausted";
+    if (status.reason == StopReason::InvalidOpCode)
+    {
+        result.status = "invalid_opcode";
+        result.opCode = status.opCode;
+    }
+    else if (cpu.trapped)
+    {
+        result.status = "trap";
+    }
+    else if (cpu.atBreakpoint)
+    {
+        result.status = "breakpoint";
+    }
+
+    result.cpu = cpu;
+    result.cpu.PC = status.PC; // The CPU is past an invalid opcode, the status has its address
+    result.stats = stats.snapshot();
+    return result;
+}
+
+/// Writes a string as a JSON string literal
+void writeString(std::FILE* out, const std::string& value)
+{
+    std::fputc('"', out);
+    for (const char c : value)
+    {
+        if (c == '"' || c == '\\')
+        {
+            std::fputc('\\', out);
+        }
+        if (static_cast<unsigned char>(c) < 0x20)
+        {
+            std::fprintf(out, "\\u%04x", unsigned(c));
+            continue;
+        }
+        std::fputc(c, out);
+    }
+    std::fputc('"', out);
+}
+
+void writeResult(std::FILE* out, const std::string& path, const Result& result)
+{
+    std::fprintf(out, "    {\"image\": ");
+    writeString(out, path);
+    std::fprintf(out, ", \"status\": \"%s\"", result.status);
+    if (!result.error.empty())
+    {
+        std::fprintf(out, ", \"error\": ");
+        writeString(out, result.error);
+        std::fprintf(out, "}");
+        return;
+    }
+    if (std::string(result.status) == "invalid_opcode")
+    {
+        std::fprintf(out, ", \"opcode\": %u", unsigned(result.opCode));
+    }
+
+    const CpuState& cpu = result.cpu;
+    const StatsSnapshot& stats = result.stats;
+    std::fprintf(out,
+                 ", \"pc\": %u, \"sp\": %u, \"a\": %u, \"x\": %u, \"y\": %u, \"sr\": %u, "
+                 "\"instructions\": %llu, \"cycles\": %llu, \"host_ns\": %llu, "
+                 "\"emulated_mhz\": %.3f}",
+                 unsigned(cpu.PC),
+                 unsigned(cpu.SP),
+                 unsigned(cpu.A),
+                 unsigned(cpu.X),
+                 unsigned(cpu.Y),
+                 unsigned(cpu.SR),
+                 static_cast<unsigned long long>(stats.instructions),
+                 static_cast<unsigned long long>(stats.cycles),
+                 static_cast<unsigned long long>(stats.hostNanoseconds),
+                 stats.emulatedMHz());
+}
+
+/// Replaces directories by the regular files in them
+std::vector<std::string> expandImages(const std::vector<std::string>& arguments)
+{
+    std::vector<std::string> images;
+    for (const std::string& argument : arguments)
+    {
+        std::error_code error;
+        if (!std::filesystem::is_directory(argument, error))
+        {
+            images.push_back(argument);
+            continue;
+        }
+
+        std::vector<std::string> files;
+        for (const auto& entry : std::filesystem::directory_iterator(argument, error))
+        {
+            if (entry.is_regular_file())
+            {
+                files.push_back(entry.path().string());
+            }
+        }
+        std::sort(files.begin(), files.end());
+        images.insert(images.end(), files.begin(), files.end());
+    }
+    return images;
+}
+
+bool parseOptions(const int argc, char* argv[], Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string argument = argv[i];
+        if (argument.size() != 2 || argument[0] != '-')
+        {
+            options.images.push_back(argument);
+            continue;
+        }
+        if (argument == "-r")
+        {
+            options.startAtResetVector = true;
+            continue;
+        }
+        if (i + 1 == argc)
+        {
+            return false;
+        }
+
+        const char* parameter = argv[++i];
+        const u64 value = std::strtoull(parameter, nullptr, 0);
+        switch (argument[1])
+        {
+            case 'l':
+            {
+                options.loadAddress = static_cast<u16>(value);
+                break;
+            }
+            case 's':
+            {
+                options.startAddress = static_cast<u16>(value);
+                options.startAddressGiven = true;
+                break;
+            }
+            case 'c':
+            {
+                options.cycles = value;
+                break;
+            }
+            case 'b':
+            {
+                options.breakpoints.set(static_cast<u16>(value));
+                break;
+            }
+            case 'j':
+            {
+                options.threadCount = std::max<unsigned>(1, static_cast<unsigned>(value));
+                break;
+            }
+            case 'o':
+            {
+                options.outputPath = parameter;
+                break;
+            }
+            default:
+            {
+                return false;
+            }
+        }
+    }
+    return !options.images.empty();
+}
+
+} // namespace run
+} // namespace c6502
+
+int main(int argc, char* argv[])
+{
+    using namespace c6502::run;
+
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::fprintf(stderr,
+                     "Usage: %s [-l load address] [-s start address] [-r] [-c cycles] "
+                     "[-b breakpoint]... [-j threads] [-o output.json] <image or directory>...\n",
+                     argv[0]);
+        return 2;
+    }
+
+    std::FILE* out = stdout;
+    if (!options.outputPath.empty())
+    {
+        out = std::fopen(options.outputPath.c_str(), "w");
+        if (out == nullptr)
+        {
+            std::perror(options.outputPath.c_str());
+            return 1;
+        }
+    }
+
+    const std::vector<std::string> images = expandImages(options.images);
+    std::vector<Result> results(images.size());
+
+    std::atomic<std::size_t> nextImage{0};
+    std::vector<std::thread> workers;
+    for (unsigned worker = 0; worker < std::min<std::size_t>(options.threadCount, images.size());
+         ++worker)
+    {
+        workers.emplace_back([&]() {
+            for (std::size_t i = nextImage++; i < images.size(); i = nextImage++)
+            {
+                results[i] = runImage(images[i], options);
+            }
+        });
+    }
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    bool allLoaded = true;
+    std::fprintf(out, "{\n  \"images\": [\n");
+    for (std::size_t i = 0; i < images.size(); ++i)
+    {
+        writeResult(out, images[i], results[i]);
+        std::fprintf(out, "%s\n", i + 1 == images.size() ? "" : ",");
+        allLoaded = allLoaded && results[i].error.empty();
+    }
+    std::fprintf(out, "  ]\n}\n");
+
+    if (out != stdout)
+    {
+        std::fclose(out);
+    }
+    return allLoaded ? 0 : 1;
+}